@@ -0,0 +1,467 @@
+#include "main.h"
+
+#define RSSI_OFFSET 128 /* rssi[dBm + RSSI_OFFSET] */
+#define RSSI_REPORT_FROM -100
+#define RSSI_REPORT_STEP 10
+#define BSSID_MASK (ANALYZE_BSSID_SLOTS - 1)
+#define MEGABYTE (1024.0 * 1024.0)
+
+typedef struct analyzer {
+    const options_t *options;
+    captureMap_t map;
+    workPool_t pool;
+    analyzeStats_t *stats[WORK_POOL_MAX_THREADS + 1]; /* one per worker, then the merged total */
+    _u32 indexedChunks;
+    _u32 skippedChunks;
+    _u32 scannedChunks;
+} analyzer_t;
+
+static const char * const TYPE_NAMES[4] = { "management", "control", "data", "extension" };
+
+static const char * const SUBTYPE_NAMES[4][16] = {
+        [IEEE80211_TYPE_MANAGEMENT] = {
+                "assoc-request", "assoc-response", "reassoc-request", "reassoc-response",
+                "probe-request", "probe-response", "timing-advert", NULL, "beacon", "atim",
+                "disassoc", "auth", "deauth", "action", "action-no-ack", NULL,
+        },
+        [IEEE80211_TYPE_CONTROL] = {
+                NULL, NULL, "trigger", "tack", "beamforming-poll", "ndp-announcement",
+                "control-frame-ext", "control-wrapper", "block-ack-request", "block-ack", "ps-poll",
+                "rts", "cts", "ack", "cf-end", "cf-end-ack",
+        },
+        [IEEE80211_TYPE_DATA] = {
+                "data", NULL, NULL, NULL, "null", NULL, NULL, NULL, "qos-data", "qos-data-cf-ack",
+                "qos-data-cf-poll", "qos-data-cf-ack-poll", "qos-null", NULL, "qos-cf-poll",
+                "qos-cf-ack-poll",
+        },
+};
+
+// Big, and kept out of the arena which is sized for the capture path
+static analyzer_t g_analyzer;
+static const analyzeBssid_t *g_ranking[ANALYZE_BSSID_SLOTS];
+
+// Finds or inserts the entry of \p bssid, NULL once the table is at its load limit
+static analyzeBssid_t *analyzeBssid(analyzeStats_t *stats, const _u8 *bssid) {
+    _u32 slot = (_u32) ieee80211AddressHash(bssid, IEEE80211_HASH_SEED) & BSSID_MASK;
+    for (;; slot = (slot + 1) & BSSID_MASK) {
+        analyzeBssid_t *entry = &stats->bssids[slot];
+        if (entry->used) {
+            if (ieee80211AddressIs(entry->bssid, bssid)) {
+                return entry;
+            }
+            continue;
+        }
+
+        if (stats->bssidCount == ANALYZE_BSSID_LIMIT) {
+            return NULL;
+        }
+        stats->bssidCount++;
+        entry->used = TRUE;
+        memcpy(entry->bssid, bssid, IEEE80211_ADDRESS_LENGTH);
+        entry->rssiMin = INT8_MAX;
+        entry->rssiMax = INT8_MIN;
+        entry->firstUs = UINT64_MAX;
+        return entry;
+    }
+}
+
+static void analyzeRecord(const options_t *options, analyzeStats_t *stats,
+        const captureRecord_t *record) {
+    if (record->timestampUs < options->fromUs || record->timestampUs > options->toUs) {
+        return;
+    }
+
+    ieee80211Frame_t parsed;
+    if (ieee80211Parse(record->frame, record->frameLength, &parsed) < 0) {
+        stats->malformed++;
+        return;
+    }
+    if (options->hasAddress && !ieee80211Carries(&parsed, options->address)) {
+        return;
+    }
+
+    stats->frames++;
+    stats->bytes += record->frameLength;
+    if (record->timestampUs < stats->firstUs) {
+        stats->firstUs = record->timestampUs;
+    }
+    if (record->timestampUs > stats->lastUs) {
+        stats->lastUs = record->timestampUs;
+    }
+    stats->typeMix[parsed.type][parsed.subtype]++;
+    if (record->hasSignal) {
+        stats->rssi[record->signalDbm + RSSI_OFFSET]++;
+    }
+
+    if (parsed.bssid == NULL) {
+        return;
+    }
+    analyzeBssid_t *entry = analyzeBssid(stats, parsed.bssid);
+    if (entry == NULL) {
+        stats->unattributed++;
+        return;
+    }
+    entry->frames++;
+    entry->bytes += record->frameLength;
+    entry->beacons += parsed.type == IEEE80211_TYPE_MANAGEMENT
+            && parsed.subtype == IEEE80211_SUBTYPE_BEACON;
+    entry->data += parsed.type == IEEE80211_TYPE_DATA;
+    if (record->hasSignal) {
+        entry->rssiFrames++;
+        entry->rssiSum += record->signalDbm;
+        if (record->signalDbm < entry->rssiMin) {
+            entry->rssiMin = record->signalDbm;
+        }
+        if (record->signalDbm > entry->rssiMax) {
+            entry->rssiMax = record->signalDbm;
+        }
+    }
+    if (record->timestampUs < entry->firstUs) {
+        entry->firstUs = record->timestampUs;
+    }
+    if (record->timestampUs > entry->lastUs) {
+        entry->lastUs = record->timestampUs;
+    }
+}
+
+// Runs on the pool: accounts every record of the chunk into the statistics of the worker
+static void analyzeChunk(void *context, _u32 worker, const workItem_t *chunk) {
+    analyzer_t *analyzer = context;
+    analyzeStats_t *stats = analyzer->stats[worker];
+
+    captureView_t view;
+    if (captureViewMap(&analyzer->map, &view, chunk->start, chunk->end) < 0) {
+        stats->unreadable += chunk->end - chunk->start;
+        return;
+    }
+
+    captureRecord_t record;
+    for (uint64_t offset = chunk->start; offset < chunk->end;) {
+        _u32 length = captureMapRead(&analyzer->map, &view, offset, &record);
+        if (length == 0) {
+            // Only an index entry that does not match the capture gets here
+            stats->malformed++;
+            break;
+        }
+        offset += length;
+        if (record.frame != NULL) {
+            analyzeRecord(analyzer->options, stats, &record);
+        }
+    }
+    captureViewUnmap(&view);
+}
+
+static void analyzeSubmit(analyzer_t *analyzer, uint64_t start, uint64_t end) {
+    workItem_t chunk = { start, end };
+    workPoolSubmit(&analyzer->pool, &chunk);
+}
+
+// Submits the blocks of the sidecar index, returns the end of the indexed part of the capture
+static uint64_t analyzeIndexed(analyzer_t *analyzer) {
+    const options_t *options = analyzer->options;
+    const captureMap_t *map = &analyzer->map;
+    uint64_t indexedEnd = map->firstRecord;
+
+    if (map->format != CAPTURE_PCAP) {
+        return indexedEnd;
+    }
+
+    static captureIndexReader_t index;
+    if (!captureIndexReaderOpen(&index, options->inputPath)) {
+        return indexedEnd;
+    }
+
+    while (captureIndexReaderNext(&index)) {
+        const captureIndexEntry_t *entry = &index.entry;
+        // Blocks are contiguous, anything else means the index belongs to another capture
+        if (entry->offset != indexedEnd || entry->length > map->size - indexedEnd) {
+            REPORT("Index of %s does not match the capture at %llu, scanning from there",
+                    options->inputPath, (unsigned long long) indexedEnd);
+            break;
+        }
+        indexedEnd += entry->length;
+
+        if (!captureIndexReaderMatches(&index, options->fromUs, options->toUs,
+                options->hasAddress ? options->address : NULL)) {
+            analyzer->skippedChunks++;
+            continue;
+        }
+        analyzer->indexedChunks++;
+        analyzeSubmit(analyzer, entry->offset, indexedEnd);
+    }
+
+    captureIndexReaderClose(&index);
+    return indexedEnd;
+}
+
+// Walks the record headers from \p offset on, submitting a chunk every ANALYZE_CHUNK_BYTES
+static void analyzeScan(analyzer_t *analyzer, uint64_t offset) {
+    captureMap_t *map = &analyzer->map;
+    uint64_t chunkStart = offset;
+
+    while (offset < map->size) {
+        _u32 length = captureMapSkip(map, offset);
+        if (length == 0) {
+            REPORT("Stopped at %llu of %llu bytes, the rest is truncated or not readable",
+                    (unsigned long long) offset, (unsigned long long) map->size);
+            break;
+        }
+        offset += length;
+
+        if (offset - chunkStart >= ANALYZE_CHUNK_BYTES) {
+            analyzer->scannedChunks++;
+            analyzeSubmit(analyzer, chunkStart, offset);
+            chunkStart = offset;
+        }
+    }
+    if (offset > chunkStart) {
+        analyzer->scannedChunks++;
+        analyzeSubmit(analyzer, chunkStart, offset);
+    }
+}
+
+static void analyzeMergeBssid(analyzeStats_t *total, const analyzeBssid_t *partial) {
+    analyzeBssid_t *entry = analyzeBssid(total, partial->bssid);
+    if (entry == NULL) {
+        total->unattributed += partial->frames;
+        return;
+    }
+    entry->frames += partial->frames;
+    entry->bytes += partial->bytes;
+    entry->beacons += partial->beacons;
+    entry->data += partial->data;
+    entry->rssiFrames += partial->rssiFrames;
+    entry->rssiSum += partial->rssiSum;
+    if (partial->rssiMin < entry->rssiMin) {
+        entry->rssiMin = partial->rssiMin;
+    }
+    if (partial->rssiMax > entry->rssiMax) {
+        entry->rssiMax = partial->rssiMax;
+    }
+    if (partial->firstUs < entry->firstUs) {
+        entry->firstUs = partial->firstUs;
+    }
+    if (partial->lastUs > entry->lastUs) {
+        entry->lastUs = partial->lastUs;
+    }
+}
+
+static void analyzeMerge(analyzeStats_t *total, const analyzeStats_t *partial) {
+    total->frames += partial->frames;
+    total->bytes += partial->bytes;
+    total->malformed += partial->malformed;
+    total->unattributed += partial->unattributed;
+    total->unreadable += partial->unreadable;
+    if (partial->firstUs < total->firstUs) {
+        total->firstUs = partial->firstUs;
+    }
+    if (partial->lastUs > total->lastUs) {
+        total->lastUs = partial->lastUs;
+    }
+    for (_u32 type = 0; type < 4; type++) {
+        for (_u32 subtype = 0; subtype < 16; subtype++) {
+            total->typeMix[type][subtype] += partial->typeMix[type][subtype];
+        }
+    }
+    for (_u32 i = 0; i < ANALYZE_RSSI_BUCKETS; i++) {
+        total->rssi[i] += partial->rssi[i];
+    }
+    for (_u32 slot = 0; slot < ANALYZE_BSSID_SLOTS; slot++) {
+        if (partial->bssids[slot].used) {
+            analyzeMergeBssid(total, &partial->bssids[slot]);
+        }
+    }
+}
+
+static double analyzePercent(uint64_t part, uint64_t whole) {
+    return whole != 0 ? 100.0 * part / whole : 0.0;
+}
+
+static void analyzeReportTypes(const analyzeStats_t *stats) {
+    REPORT("Frame types:");
+    for (_u32 type = 0; type < 4; type++) {
+        for (_u32 subtype = 0; subtype < 16; subtype++) {
+            uint64_t frames = stats->typeMix[type][subtype];
+            if (frames == 0) {
+                continue;
+            }
+            char name[32];
+            if (SUBTYPE_NAMES[type][subtype] != NULL) {
+                snprintf(name, sizeof(name), "%s", SUBTYPE_NAMES[type][subtype]);
+            } else {
+                snprintf(name, sizeof(name), "subtype %u", subtype);
+            }
+            REPORT("  %-10s %-20s %12llu %6.2f%%", TYPE_NAMES[type], name,
+                    (unsigned long long) frames, analyzePercent(frames, stats->frames));
+        }
+    }
+}
+
+static int analyzeRssiAt(const analyzeStats_t *stats, uint64_t rank) {
+    uint64_t seen = 0;
+    for (_u32 i = 0; i < ANALYZE_RSSI_BUCKETS; i++) {
+        seen += stats->rssi[i];
+        if (seen > rank) {
+            return (int) i - RSSI_OFFSET;
+        }
+    }
+    return ANALYZE_RSSI_BUCKETS - 1 - RSSI_OFFSET;
+}
+
+static void analyzeReportRssi(const analyzeStats_t *stats) {
+    uint64_t frames = 0;
+    for (_u32 i = 0; i < ANALYZE_RSSI_BUCKETS; i++) {
+        frames += stats->rssi[i];
+    }
+    if (frames == 0) {
+        REPORT("RSSI: no frame carries a radiotap antenna signal");
+        return;
+    }
+
+    REPORT("RSSI, dBm: p10 %d, median %d, p90 %d over %llu frames",
+            analyzeRssiAt(stats, frames / 10), analyzeRssiAt(stats, frames / 2),
+            analyzeRssiAt(stats, frames * 9 / 10), (unsigned long long) frames);
+
+    // Steps of RSSI_REPORT_STEP from RSSI_REPORT_FROM to 0 dBm, everything outside in two more ranges
+    const int MAX_DBM = ANALYZE_RSSI_BUCKETS - RSSI_OFFSET;
+    for (int low = -RSSI_OFFSET, high = RSSI_REPORT_FROM; low < MAX_DBM;
+            high = high < 0 ? high + RSSI_REPORT_STEP : MAX_DBM) {
+        uint64_t range = 0;
+        for (int dbm = low; dbm < high; dbm++) {
+            range += stats->rssi[dbm + RSSI_OFFSET];
+        }
+        if (range != 0) {
+            REPORT("  %4d to %4d %12llu %6.2f%%", low, high - 1, (unsigned long long) range,
+                    analyzePercent(range, frames));
+        }
+        low = high;
+    }
+}
+
+static int analyzeByFrames(const void *a, const void *b) {
+    const analyzeBssid_t *left = *(const analyzeBssid_t * const *) a;
+    const analyzeBssid_t *right = *(const analyzeBssid_t * const *) b;
+    return left->frames < right->frames ? 1 : left->frames > right->frames ? -1 : 0;
+}
+
+static void analyzeReportBssids(const analyzeStats_t *stats) {
+    _u32 count = 0;
+    for (_u32 slot = 0; slot < ANALYZE_BSSID_SLOTS; slot++) {
+        if (stats->bssids[slot].used) {
+            g_ranking[count++] = &stats->bssids[slot];
+        }
+    }
+    qsort(g_ranking, count, sizeof(g_ranking[0]), analyzeByFrames);
+
+    REPORT("BSSIDs: %u, %llu frames not attributed to one that fitted into the table", count,
+            (unsigned long long) stats->unattributed);
+    REPORT("  %-17s %10s %12s %9s %10s %5s %5s %5s %10s", "bssid", "frames", "bytes", "beacons",
+            "data", "rssi", "min", "max", "seconds");
+    for (_u32 i = 0; i < count && i < ANALYZE_TOP_BSSIDS; i++) {
+        const analyzeBssid_t *entry = g_ranking[i];
+        const _u8 *a = entry->bssid;
+        BOOL hasRssi = entry->rssiFrames != 0;
+        REPORT("  %02x:%02x:%02x:%02x:%02x:%02x %10llu %12llu %9llu %10llu %5d %5d %5d %10.3f",
+                a[0], a[1], a[2], a[3], a[4], a[5], (unsigned long long) entry->frames,
+                (unsigned long long) entry->bytes, (unsigned long long) entry->beacons,
+                (unsigned long long) entry->data,
+                hasRssi ? (int) (entry->rssiSum / (int64_t) entry->rssiFrames) : 0,
+                hasRssi ? entry->rssiMin : 0, hasRssi ? entry->rssiMax : 0,
+                (entry->lastUs - entry->firstUs) / (double) MICROSECONDS_IN_SECOND);
+    }
+}
+
+static void analyzeReport(const analyzer_t *analyzer, const analyzeStats_t *total,
+        uint64_t elapsedUs) {
+    const captureMap_t *map = &analyzer->map;
+    double seconds = elapsedUs / (double) MICROSECONDS_IN_SECOND;
+
+    REPORT("%s: %s, %llu bytes in %u indexed and %u scanned chunks, %u skipped by the index",
+            analyzer->options->inputPath, map->format == CAPTURE_PCAP ? "pcap" : "pcapng",
+            (unsigned long long) map->size, analyzer->indexedChunks, analyzer->scannedChunks,
+            analyzer->skippedChunks);
+    REPORT("Analyzed in %.3f s, %.1f MB/s, %.0f frames/s", seconds,
+            seconds > 0 ? map->size / MEGABYTE / seconds : 0.0,
+            seconds > 0 ? total->frames / seconds : 0.0);
+    REPORT("Frames: %llu, %llu bytes, %llu malformed, spanning %.3f s",
+            (unsigned long long) total->frames, (unsigned long long) total->bytes,
+            (unsigned long long) total->malformed,
+            total->frames != 0 ?
+                    (total->lastUs - total->firstUs) / (double) MICROSECONDS_IN_SECOND : 0.0);
+    if (total->unreadable != 0) {
+        REPORT("%llu bytes were not analyzed, they could not be mapped",
+                (unsigned long long) total->unreadable);
+    }
+
+    analyzeReportTypes(total);
+    analyzeReportRssi(total);
+    analyzeReportBssids(total);
+    workPoolReport(&analyzer->pool);
+}
+
+static analyzeStats_t *analyzeStatsAlloc() {
+    // Page aligned, so the workers never share a cache line, and zeroed
+    analyzeStats_t *stats = VirtualAlloc(NULL, sizeof(analyzeStats_t), MEM_COMMIT | MEM_RESERVE,
+            PAGE_READWRITE);
+    if (stats == NULL) {
+        DEBUG("[ERROR] Failed to allocate %u bytes: %lu", (unsigned) sizeof(analyzeStats_t),
+                GetLastError());
+        return NULL;
+    }
+    stats->firstUs = UINT64_MAX;
+    return stats;
+}
+
+static void analyzeStatsFree(analyzer_t *analyzer) {
+    for (_u32 i = 0; i <= WORK_POOL_MAX_THREADS; i++) {
+        if (analyzer->stats[i] != NULL) {
+            VirtualFree(analyzer->stats[i], 0, MEM_RELEASE);
+            analyzer->stats[i] = NULL;
+        }
+    }
+}
+
+_i32 analyzeCapture(const options_t *options) {
+    analyzer_t *analyzer = &g_analyzer;
+    analyzer->options = options;
+
+    if (latencyInit() < 0 || captureMapOpen(&analyzer->map, options->inputPath) < 0) {
+        return -1;
+    }
+    if (analyzer->map.format == CAPTURE_PCAP
+            && analyzer->map.interfaces[0].linkType != LINKTYPE_IEEE802_11_RADIOTAP
+            && analyzer->map.interfaces[0].linkType != LINKTYPE_IEEE802_11) {
+        DEBUG("[ERROR] %s does not hold 802.11 frames", options->inputPath);
+        captureMapClose(&analyzer->map);
+        return -1;
+    }
+
+    _u32 threads = options->threads != 0 ? options->threads : workPoolDefaultThreads();
+    BOOL allocated = TRUE;
+    for (_u32 i = 0; i < threads; i++) {
+        analyzer->stats[i] = analyzeStatsAlloc();
+        allocated = allocated && analyzer->stats[i] != NULL;
+    }
+    analyzeStats_t *total = analyzer->stats[WORK_POOL_MAX_THREADS] = analyzeStatsAlloc();
+    if (!allocated || total == NULL
+            || workPoolStart(&analyzer->pool, threads, analyzeChunk, analyzer) < 0) {
+        analyzeStatsFree(analyzer);
+        captureMapClose(&analyzer->map);
+        return -1;
+    }
+
+    latencyTick_t start = latencyNow();
+    analyzeScan(analyzer, analyzeIndexed(analyzer));
+    workPoolFinish(&analyzer->pool);
+
+    for (_u32 i = 0; i < threads; i++) {
+        analyzeMerge(total, analyzer->stats[i]);
+    }
+    uint64_t elapsedUs = latencyTicksToMicroseconds(latencyNow() - start);
+
+    analyzeReport(analyzer, total, elapsedUs);
+
+    analyzeStatsFree(analyzer);
+    captureMapClose(&analyzer->map);
+    return 0;
+}
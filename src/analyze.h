@@ -0,0 +1,63 @@
+#ifndef __ANALYZE_H__
+#define __ANALYZE_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+#include "ieee80211.h"
+#include "options.h"
+
+/*
+ * Offline analyzer for captures written by the sniffer, or saved as pcapng by WireShark.
+ *
+ * The capture is cut into record-aligned chunks of about ANALYZE_CHUNK_BYTES, mapped one by one: the
+ * blocks of the sidecar index where there is one, otherwise a header-only walk of the file that hands
+ * out every chunk as soon as it is found. Chunks run on a work-stealing pool, every thread accumulates
+ * its own statistics and the partial results are merged once the pool is done, so nothing is shared
+ * on the per-record path and the throughput is bounded by the disk.
+ */
+#define ANALYZE_CHUNK_BYTES (1024 * 1024)
+#define ANALYZE_BSSID_SLOTS 4096 /* per thread, power of two */
+#define ANALYZE_BSSID_LIMIT (ANALYZE_BSSID_SLOTS / 4 * 3) /* keeps the probe sequences short */
+#define ANALYZE_TOP_BSSIDS 20
+#define ANALYZE_RSSI_BUCKETS 256 /* one per dBm, -128 to 127 */
+
+typedef struct analyzeBssid {
+    BOOL used;
+    _u8 bssid[IEEE80211_ADDRESS_LENGTH];
+    _i8 rssiMin;
+    _i8 rssiMax;
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t beacons;
+    uint64_t data;
+    uint64_t rssiFrames;
+    int64_t rssiSum;
+    uint64_t firstUs;
+    uint64_t lastUs;
+} analyzeBssid_t;
+
+typedef struct analyzeStats {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t malformed;
+    uint64_t unattributed; /* frames of BSSIDs that did not fit into the table */
+    uint64_t unreadable; /* bytes of chunks that could not be mapped */
+    uint64_t firstUs;
+    uint64_t lastUs;
+    uint64_t typeMix[4][16]; /* by type and subtype */
+    uint64_t rssi[ANALYZE_RSSI_BUCKETS];
+    _u32 bssidCount;
+    analyzeBssid_t bssids[ANALYZE_BSSID_SLOTS];
+} analyzeStats_t;
+
+/*!
+ \brief Reports frame counts, the frame type mix, the RSSI distribution and per-BSSID counters of
+ options->inputPath, limited to [fromUs, toUs] and, when given, to the frames carrying
+ options->address.
+
+ \return 0 on success, negative on error
+ */
+_i32 analyzeCapture(const options_t *options);
+
+#endif /* __ANALYZE_H__ */
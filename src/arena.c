@@ -0,0 +1,70 @@
+#include "main.h"
+
+typedef struct arenaUsage {
+    size_t requested; /* bytes asked for by the subsystem */
+    size_t reserved; /* bytes taken from the arena, alignment padding included */
+    _u32 allocations;
+} arenaUsage_t;
+
+static const char * const SUBSYSTEM_NAMES[ARENA_SUBSYSTEM_COUNT] = {
+        [ARENA_CAPTURE] = "capture",
+        [ARENA_OUTPUT] = "output",
+        [ARENA_LATENCY] = "latency",
+        [ARENA_INDEX] = "index",
+        [ARENA_TRIGGER] = "trigger",
+        [ARENA_SHAPING] = "shaping",
+        [ARENA_INJECT] = "inject",
+};
+
+static _u8 g_arena[ARENA_SIZE] __attribute__((aligned(ARENA_ALIGNMENT)));
+static size_t g_arenaUsed = 0;
+static BOOL g_arenaSealed = FALSE;
+static arenaUsage_t g_arenaUsage[ARENA_SUBSYSTEM_COUNT];
+
+void *arenaAlloc(e_ArenaSubsystem subsystem, size_t size) {
+    assert(subsystem < ARENA_SUBSYSTEM_COUNT);
+
+    if (g_arenaSealed) {
+        DEBUG("[ERROR] Arena is sealed, %s can not allocate %u bytes", SUBSYSTEM_NAMES[subsystem],
+                (unsigned) size);
+        return NULL;
+    }
+
+    size_t reserved = (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+    if (reserved > ARENA_SIZE - g_arenaUsed) {
+        DEBUG("[ERROR] Arena exhausted: %s needs %u bytes, %u of %u left", SUBSYSTEM_NAMES[subsystem],
+                (unsigned) reserved, (unsigned) (ARENA_SIZE - g_arenaUsed), (unsigned) ARENA_SIZE);
+        return NULL;
+    }
+
+    void *memory = &g_arena[g_arenaUsed];
+    g_arenaUsed += reserved;
+
+    g_arenaUsage[subsystem].requested += size;
+    g_arenaUsage[subsystem].reserved += reserved;
+    g_arenaUsage[subsystem].allocations++;
+
+    return memory;
+}
+
+void arenaSeal() {
+    g_arenaSealed = TRUE;
+}
+
+size_t arenaUsed() {
+    return g_arenaUsed;
+}
+
+void arenaReport() {
+    REPORT("Arena footprint (%u bytes ceiling):", (unsigned) ARENA_SIZE);
+    for (int i = 0; i < ARENA_SUBSYSTEM_COUNT; i++) {
+        if (g_arenaUsage[i].allocations == 0) {
+            continue;
+        }
+        REPORT("  %-10s %8u bytes in %u allocation(s), %u requested", SUBSYSTEM_NAMES[i],
+                (unsigned) g_arenaUsage[i].reserved, g_arenaUsage[i].allocations,
+                (unsigned) g_arenaUsage[i].requested);
+    }
+    REPORT("  %-10s %8u bytes", "total", (unsigned) g_arenaUsed);
+    REPORT("  %-10s %8u bytes", "free", (unsigned) (ARENA_SIZE - g_arenaUsed));
+}
@@ -0,0 +1,47 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/*
+ * Every buffer of the capture machinery is carved out of one statically sized arena at start-up.
+ * The arena is sealed before the capture loop starts, so nothing is allocated on the capture path
+ * and ARENA_SIZE is a hard ceiling for the buffers of the sniffer and the traffic generator.
+ * The offline commands (extract, shm-dump, analyze) and the template loader of the generator keep
+ * their record and index buffers outside of it. Override with -D ARENA_SIZE=<bytes>.
+ */
+#ifndef ARENA_SIZE
+#define ARENA_SIZE (256 * 1024)
+#endif
+
+#define ARENA_ALIGNMENT 8
+
+typedef enum
+{
+    ARENA_CAPTURE, /* receive buffer */
+    ARENA_OUTPUT, /* output batch */
+    ARENA_LATENCY, /* per-thread latency histograms */
+    ARENA_INDEX, /* open block of the sidecar index */
+    ARENA_TRIGGER, /* pre-trigger buffer */
+    ARENA_SHAPING, /* per-source token buckets */
+    ARENA_INJECT, /* frame template of the traffic generator */
+
+    ARENA_SUBSYSTEM_COUNT
+} e_ArenaSubsystem;
+
+/*!
+ \brief Allocates \p size bytes for \p subsystem from the static arena
+
+ \return pointer to zeroed memory, NULL when the arena is exhausted or already sealed
+ */
+void *arenaAlloc(e_ArenaSubsystem subsystem, size_t size);
+
+// Forbids any further allocation, called right before the capture loop
+void arenaSeal();
+
+size_t arenaUsed();
+
+// Prints the footprint of every subsystem and the remaining headroom
+void arenaReport();
+
+#endif /* __ARENA_H__ */
@@ -0,0 +1,162 @@
+#include "main.h"
+
+// Kirsch-Mitzenmacher double hashing: bit i = h1 + i * h2
+#define BLOOM_BIT(hash, i, bits) ((((_u32) (hash)) + (i) * ((_u32) ((hash) >> 32) | 1)) % (bits))
+
+static void captureIndexBloomAdd(captureIndexBlock_t *block, const _u8 *address) {
+    if (address == NULL) {
+        return;
+    }
+
+    uint64_t hash = ieee80211AddressHash(address, IEEE80211_HASH_SEED);
+    for (_u32 i = 0; i < INDEX_BLOOM_HASHES; i++) {
+        _u32 bit = BLOOM_BIT(hash, i, INDEX_BLOOM_BYTES * 8);
+        block->bloom[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+BOOL captureIndexReaderMayContain(const captureIndexReader_t *reader, const _u8 *address) {
+    uint64_t hash = ieee80211AddressHash(address, IEEE80211_HASH_SEED);
+    for (_u32 i = 0; i < reader->header.bloomHashes; i++) {
+        _u32 bit = BLOOM_BIT(hash, i, reader->header.bloomBytes * 8U);
+        if ((reader->bloom[bit / 8] & (1 << (bit % 8))) == 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+BOOL captureIndexReaderMatches(const captureIndexReader_t *reader, uint64_t fromUs, uint64_t toUs,
+        const _u8 *address) {
+    if (reader->entry.lastUs < fromUs || reader->entry.firstUs > toUs) {
+        return FALSE;
+    }
+    return address == NULL || captureIndexReaderMayContain(reader, address);
+}
+
+BOOL captureIndexReaderOpen(captureIndexReader_t *reader, const char *capturePath) {
+    char indexPath[MAX_PATH];
+    snprintf(indexPath, sizeof(indexPath), "%s" INDEX_SUFFIX, capturePath);
+
+    reader->file = fopen(indexPath, "rb");
+    if (reader->file == NULL) {
+        REPORT("No index %s, scanning the whole capture", indexPath);
+        return FALSE;
+    }
+
+    captureIndexHeader_t *header = &reader->header;
+    if (fread(header, sizeof(*header), 1, reader->file) != 1 || header->magic != INDEX_MAGIC
+            || header->version != INDEX_VERSION || header->bloomBytes == 0
+            || header->bloomBytes > INDEX_MAX_BLOOM_BYTES || header->bloomHashes == 0
+            || header->bloomHashes > INDEX_MAX_BLOOM_HASHES) {
+        REPORT("Index %s is not compatible, scanning the whole capture", indexPath);
+        captureIndexReaderClose(reader);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL captureIndexReaderNext(captureIndexReader_t *reader) {
+    return fread(&reader->entry, sizeof(reader->entry), 1, reader->file) == 1
+            && fread(reader->bloom, reader->header.bloomBytes, 1, reader->file) == 1;
+}
+
+void captureIndexReaderClose(captureIndexReader_t *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+_i32 captureIndexOpen(captureIndex_t *index, const char *capturePath) {
+    char indexPath[MAX_PATH];
+    if (snprintf(indexPath, sizeof(indexPath), "%s" INDEX_SUFFIX, capturePath)
+            >= (int) sizeof(indexPath)) {
+        DEBUG("[ERROR] Index path is too long");
+        return -1;
+    }
+
+    index->block = arenaAlloc(ARENA_INDEX, sizeof(captureIndexBlock_t));
+    if (index->block == NULL) {
+        return -1;
+    }
+
+    index->handle = CreateFile(indexPath, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL, NULL);
+    if (index->handle == INVALID_HANDLE_VALUE) {
+        DEBUG("[ERROR] Failed to create %s", indexPath);
+        return -1;
+    }
+
+    captureIndexHeader_t header = {
+            .magic = INDEX_MAGIC,
+            .version = INDEX_VERSION,
+            .bloomBytes = INDEX_BLOOM_BYTES,
+            .blockBytes = INDEX_BLOCK_BYTES,
+            .bloomHashes = INDEX_BLOOM_HASHES,
+    };
+    DWORD byteWritten = 0;
+    if (WriteFile(index->handle, &header, sizeof(header), &byteWritten, NULL) == FALSE) {
+        DEBUG("[ERROR] Failed to write index header");
+        return -1;
+    }
+    return 0;
+}
+
+BOOL captureIndexBlockFull(const captureIndex_t *index, _u32 length) {
+    const captureIndexEntry_t *entry = &index->block->entry;
+    return entry->records > 0 && entry->length + length > INDEX_BLOCK_BYTES;
+}
+
+void captureIndexAdd(captureIndex_t *index, uint64_t offset, const _u8 *record, _u32 length) {
+    captureIndexBlock_t *block = index->block;
+    captureIndexEntry_t *entry = &block->entry;
+    uint64_t timestampUs = pcapRecordTimestamp((const pcapRecordHeader_t *) record);
+
+    if (entry->records == 0) {
+        entry->offset = offset;
+        entry->firstUs = timestampUs;
+        entry->lastUs = timestampUs;
+    }
+    if (timestampUs < entry->firstUs) {
+        entry->firstUs = timestampUs;
+    }
+    if (timestampUs > entry->lastUs) {
+        entry->lastUs = timestampUs;
+    }
+    entry->length += length;
+    entry->records++;
+
+    _u32 frameLength = 0;
+    const _u8 *frame = pcapRecordFrame(record, &frameLength);
+    ieee80211Frame_t parsed;
+    if (frame != NULL && ieee80211Parse(frame, frameLength, &parsed) == 0) {
+        captureIndexBloomAdd(block, parsed.addr1);
+        captureIndexBloomAdd(block, parsed.addr2);
+        captureIndexBloomAdd(block, parsed.addr3);
+    }
+}
+
+_i32 captureIndexEmitBlock(captureIndex_t *index) {
+    if (index->block->entry.records == 0) {
+        return 0;
+    }
+
+    // The Bloom filter directly follows the entry, the trailing padding of the block is not written
+    DWORD byteWritten = 0;
+    if (WriteFile(index->handle, index->block, sizeof(captureIndexEntry_t) + INDEX_BLOOM_BYTES,
+            &byteWritten, NULL) == FALSE) {
+        DEBUG("[ERROR] Failed to write index entry");
+        return -1;
+    }
+
+    memset(index->block, 0, sizeof(captureIndexBlock_t));
+    return 0;
+}
+
+_i32 captureIndexClose(captureIndex_t *index) {
+    _i32 retVal = captureIndexEmitBlock(index);
+    CloseHandle(index->handle);
+    index->handle = INVALID_HANDLE_VALUE;
+    return retVal;
+}
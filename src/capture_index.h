@@ -0,0 +1,109 @@
+#ifndef __CAPTURE_INDEX_H__
+#define __CAPTURE_INDEX_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "simplelink.h"
+#include "ieee80211.h"
+
+/*
+ * Sidecar index written next to a capture file as "<capture>.idx".
+ *
+ * Records are grouped into blocks of about INDEX_BLOCK_BYTES. Every block is described by one entry:
+ * its file offset and length, its timestamp range and a Bloom filter of the addresses of its frames.
+ * An entry is appended as soon as its block is complete and the capture data it points to has been
+ * flushed, so the index is usable while the capture is still running.
+ *
+ * The Bloom filter is sized for a block full of short frames from thousands of distinct, e.g.
+ * randomized, addresses: 4 KiB and 5 hashes stay below 2% false positives up to 4000 addresses.
+ * Its size and hash count are recorded in the header, readers take them from there.
+ */
+#ifndef INDEX_BLOCK_BYTES
+#define INDEX_BLOCK_BYTES (1024 * 1024)
+#endif
+
+#ifndef INDEX_BLOOM_BYTES
+#define INDEX_BLOOM_BYTES 4096
+#endif
+#define INDEX_BLOOM_HASHES 5
+#define INDEX_MAX_BLOOM_BYTES (16 * 1024) /* largest filter a reader accepts */
+#define INDEX_MAX_BLOOM_HASHES 16
+
+// The header stores the size in 16 bits, and readers reject filters above INDEX_MAX_BLOOM_BYTES
+#if INDEX_BLOOM_BYTES < 1 || INDEX_BLOOM_BYTES > INDEX_MAX_BLOOM_BYTES
+#error "INDEX_BLOOM_BYTES must be 1 to INDEX_MAX_BLOOM_BYTES"
+#endif
+
+#define INDEX_MAGIC 0x58494343 /* "CCIX" */
+#define INDEX_VERSION 1
+#define INDEX_SUFFIX ".idx"
+
+typedef struct captureIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bloomBytes;
+    uint32_t blockBytes;
+    uint32_t bloomHashes;
+} captureIndexHeader_t;
+
+// Followed in the file by header.bloomBytes octets of Bloom filter over addr1, addr2 and addr3
+typedef struct captureIndexEntry {
+    uint64_t offset; /* of the first record of the block */
+    uint32_t length; /* of all records of the block, in octets */
+    uint32_t records;
+    uint64_t firstUs; /* earliest timestamp in the block */
+    uint64_t lastUs; /* latest timestamp in the block */
+} captureIndexEntry_t;
+
+typedef struct captureIndexBlock {
+    captureIndexEntry_t entry;
+    uint8_t bloom[INDEX_BLOOM_BYTES];
+} captureIndexBlock_t;
+
+typedef struct captureIndex {
+    HANDLE handle;
+    captureIndexBlock_t *block;
+} captureIndex_t;
+
+typedef struct captureIndexReader {
+    FILE *file;
+    captureIndexHeader_t header;
+    captureIndexEntry_t entry; /* the entry captureIndexReaderNext() read */
+    uint8_t bloom[INDEX_MAX_BLOOM_BYTES];
+} captureIndexReader_t;
+
+_i32 captureIndexOpen(captureIndex_t *index, const char *capturePath);
+
+// TRUE when a record of \p length octets would not fit into the open block
+BOOL captureIndexBlockFull(const captureIndex_t *index, _u32 length);
+
+// Accounts the record that is about to be written at \p offset of the capture file
+void captureIndexAdd(captureIndex_t *index, uint64_t offset, const _u8 *record, _u32 length);
+
+// Appends the entry of the open block to the index file and starts a new block
+_i32 captureIndexEmitBlock(captureIndex_t *index);
+
+_i32 captureIndexClose(captureIndex_t *index);
+
+// Opens the index of \p capturePath, FALSE when there is none or it can not be used
+BOOL captureIndexReaderOpen(captureIndexReader_t *reader, const char *capturePath);
+
+// Reads the next entry with its Bloom filter, FALSE at the end of the index
+BOOL captureIndexReaderNext(captureIndexReader_t *reader);
+
+void captureIndexReaderClose(captureIndexReader_t *reader);
+
+// FALSE when no frame of the block of the current entry carries \p address
+BOOL captureIndexReaderMayContain(const captureIndexReader_t *reader, const _u8 *address);
+
+/*!
+ \brief Tells whether the block of the current entry may hold frames of [\p fromUs, \p toUs] that
+ carry \p address, or any address when it is NULL.
+
+ \return FALSE when the block certainly holds none
+ */
+BOOL captureIndexReaderMatches(const captureIndexReader_t *reader, uint64_t fromUs, uint64_t toUs,
+        const _u8 *address);
+
+#endif /* __CAPTURE_INDEX_H__ */
@@ -0,0 +1,341 @@
+#include "main.h"
+
+typedef struct pcapngBlockHeader {
+    uint32_t type;
+    uint32_t totalLength; /* repeated after the body */
+} pcapngBlockHeader_t;
+
+typedef struct pcapngInterfaceDescription {
+    uint16_t linkType;
+    uint16_t reserved;
+    uint32_t snapLength;
+} pcapngInterfaceDescription_t;
+
+typedef struct pcapngEnhancedPacket {
+    uint32_t interfaceId;
+    uint32_t timestampHigh;
+    uint32_t timestampLow;
+    uint32_t capturedLength;
+    uint32_t originalLength;
+} pcapngEnhancedPacket_t;
+
+typedef struct pcapngOption {
+    uint16_t code;
+    uint16_t length; /* of the value, which is padded to 4 octets */
+} pcapngOption_t;
+
+#define PCAPNG_ALIGNMENT 4
+#define PCAPNG_MIN_BLOCK (sizeof(pcapngBlockHeader_t) + sizeof(uint32_t))
+
+static uint64_t captureToMicroseconds(uint64_t timestamp, uint64_t unitsPerSecond) {
+    return timestamp / unitsPerSecond * MICROSECONDS_IN_SECOND
+            + timestamp % unitsPerSecond * MICROSECONDS_IN_SECOND / unitsPerSecond;
+}
+
+// if_tsresol: a power of ten, or of two when the top bit is set
+static uint64_t captureResolution(_u8 tsresol) {
+    uint64_t units = 1;
+    _u8 exponent = tsresol & 0x7F;
+    if (exponent > ((tsresol & 0x80) ? 63 : 19)) {
+        return 0;
+    }
+    for (_u8 i = 0; i < exponent; i++) {
+        units = (tsresol & 0x80) ? units << 1 : units * 10;
+    }
+    return units;
+}
+
+static const _u8 *captureAt(const captureView_t *view, uint64_t offset) {
+    return &view->base[offset - view->start];
+}
+
+static _u32 capturePcapLength(const captureView_t *view, uint64_t offset) {
+    pcapRecordHeader_t header;
+    if (view->end - offset < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, captureAt(view, offset), sizeof(header));
+    if (header.incl_len > CAPTURE_MAX_RECORD || view->end - offset - sizeof(header) < header.incl_len) {
+        return 0;
+    }
+    return sizeof(header) + header.incl_len;
+}
+
+static _u32 capturePcapngLength(const captureView_t *view, uint64_t offset) {
+    pcapngBlockHeader_t header;
+    uint32_t trailer;
+    if (view->end - offset < PCAPNG_MIN_BLOCK) {
+        return 0;
+    }
+    memcpy(&header, captureAt(view, offset), sizeof(header));
+    if (header.totalLength < PCAPNG_MIN_BLOCK || header.totalLength % PCAPNG_ALIGNMENT != 0
+            || header.totalLength > CAPTURE_MAX_BLOCK || header.totalLength > view->end - offset) {
+        return 0;
+    }
+    memcpy(&trailer, captureAt(view, offset + header.totalLength - sizeof(trailer)), sizeof(trailer));
+    return trailer == header.totalLength ? header.totalLength : 0;
+}
+
+static _u32 captureBlockLength(const captureMap_t *map, const captureView_t *view, uint64_t offset) {
+    if (offset < view->start || offset >= view->end) {
+        return 0;
+    }
+    return map->format == CAPTURE_PCAP ?
+            capturePcapLength(view, offset) : capturePcapngLength(view, offset);
+}
+
+static void captureLearnInterface(captureMap_t *map, const _u8 *body, _u32 length) {
+    pcapngInterfaceDescription_t description;
+    if (length < sizeof(description)) {
+        return;
+    }
+    memcpy(&description, body, sizeof(description));
+
+    captureInterface_t learned = {
+            .linkType = description.linkType,
+            .unitsPerSecond = MICROSECONDS_IN_SECOND,
+    };
+
+    _u32 offset = sizeof(description);
+    pcapngOption_t option;
+    while (offset + sizeof(option) <= length) {
+        memcpy(&option, &body[offset], sizeof(option));
+        offset += sizeof(option);
+        if (option.code == PCAPNG_OPTION_END || offset + option.length > length) {
+            break;
+        }
+        if (option.code == PCAPNG_OPTION_TSRESOL && option.length == 1) {
+            learned.unitsPerSecond = captureResolution(body[offset]);
+        }
+        offset += (option.length + PCAPNG_ALIGNMENT - 1) & ~(PCAPNG_ALIGNMENT - 1);
+    }
+
+    if (map->interfaceCount == CAPTURE_MAX_INTERFACES) {
+        DEBUG("[ERROR] More than %u interfaces, the others are ignored", CAPTURE_MAX_INTERFACES);
+        return;
+    }
+    if (learned.unitsPerSecond == 0) {
+        DEBUG("[ERROR] Unsupported timestamp resolution of interface %u", map->interfaceCount);
+        learned.unitsPerSecond = MICROSECONDS_IN_SECOND;
+    }
+    map->interfaces[map->interfaceCount++] = learned;
+}
+
+_u32 captureMapSkip(captureMap_t *map, uint64_t offset) {
+    captureView_t *scan = &map->scan;
+    if (offset >= map->size) {
+        return 0;
+    }
+    // Slides the window once a block of CAPTURE_MAX_BLOCK bytes at offset might not fit into it
+    if (offset < scan->start || offset >= scan->end
+            || (scan->end < map->size && scan->end - offset < CAPTURE_MAX_BLOCK)) {
+        captureViewUnmap(scan);
+        if (captureViewMap(map, scan, offset, offset + CAPTURE_SCAN_WINDOW) < 0) {
+            return 0;
+        }
+    }
+
+    _u32 length = captureBlockLength(map, scan, offset);
+    if (length == 0 || map->format == CAPTURE_PCAP) {
+        return length;
+    }
+
+    pcapngBlockHeader_t header;
+    memcpy(&header, captureAt(scan, offset), sizeof(header));
+    if (header.type == PCAPNG_SECTION_HEADER) {
+        // Interface ids restart with every section
+        REPORT("Only the first section of the pcapng file is read, the next one starts at %llu",
+                (unsigned long long) offset);
+        return 0;
+    }
+    if (header.type == PCAPNG_INTERFACE_DESCRIPTION) {
+        captureLearnInterface(map, captureAt(scan, offset + sizeof(header)),
+                length - PCAPNG_MIN_BLOCK);
+    }
+    return length;
+}
+
+static void captureDecodeFrame(uint16_t linkType, const _u8 *data, _u32 length,
+        captureRecord_t *record) {
+    if (linkType == LINKTYPE_IEEE802_11) {
+        record->frame = data;
+        record->frameLength = length;
+        return;
+    }
+    if (linkType != LINKTYPE_IEEE802_11_RADIOTAP || length < sizeof(ieee80211RadiotapHeader_t)) {
+        return;
+    }
+
+    ieee80211RadiotapHeader_t radiotap;
+    memcpy(&radiotap, data, sizeof(radiotap));
+    if (radiotap.it_len < sizeof(radiotap) || radiotap.it_len > length) {
+        return;
+    }
+    record->hasSignal = pcapRadiotapSignal(data, radiotap.it_len, &record->signalDbm);
+    record->frame = data + radiotap.it_len;
+    record->frameLength = length - radiotap.it_len;
+}
+
+_u32 captureMapRead(const captureMap_t *map, const captureView_t *view, uint64_t offset,
+        captureRecord_t *record) {
+    memset(record, 0, sizeof(*record));
+    _u32 length = captureBlockLength(map, view, offset);
+    if (length == 0) {
+        return 0;
+    }
+
+    const _u8 *block = captureAt(view, offset);
+    if (map->format == CAPTURE_PCAP) {
+        pcapRecordHeader_t header;
+        memcpy(&header, block, sizeof(header));
+        const captureInterface_t *iface = &map->interfaces[0];
+        record->timestampUs = (uint64_t) header.ts_sec * MICROSECONDS_IN_SECOND
+                + captureToMicroseconds(header.ts_usec, iface->unitsPerSecond);
+        captureDecodeFrame(iface->linkType, block + sizeof(header), header.incl_len, record);
+        return length;
+    }
+
+    pcapngBlockHeader_t header;
+    pcapngEnhancedPacket_t packet;
+    memcpy(&header, block, sizeof(header));
+    if (header.type != PCAPNG_ENHANCED_PACKET || length < PCAPNG_MIN_BLOCK + sizeof(packet)) {
+        return length;
+    }
+    memcpy(&packet, block + sizeof(header), sizeof(packet));
+    if (packet.interfaceId >= map->interfaceCount
+            || packet.capturedLength > length - PCAPNG_MIN_BLOCK - sizeof(packet)) {
+        return length;
+    }
+
+    const captureInterface_t *iface = &map->interfaces[packet.interfaceId];
+    uint64_t timestamp = (uint64_t) packet.timestampHigh << 32 | packet.timestampLow;
+    record->timestampUs = captureToMicroseconds(timestamp, iface->unitsPerSecond);
+    captureDecodeFrame(iface->linkType, block + sizeof(header) + sizeof(packet),
+            packet.capturedLength, record);
+    return length;
+}
+
+// Reads the file header through the window of the scanner, mapped at the start of the file
+static _i32 captureMapDetect(captureMap_t *map) {
+    const captureView_t *scan = &map->scan;
+    uint32_t magic;
+    if (scan->end < sizeof(magic)) {
+        return -1;
+    }
+    memcpy(&magic, scan->base, sizeof(magic));
+
+    if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NANOSECONDS) {
+        wireSharkGlobalHeader_t gHeader;
+        if (scan->end < sizeof(gHeader)) {
+            return -1;
+        }
+        memcpy(&gHeader, scan->base, sizeof(gHeader));
+        map->format = CAPTURE_PCAP;
+        map->firstRecord = sizeof(gHeader);
+        map->interfaces[0].linkType = gHeader.network;
+        // pcap records split the timestamp into seconds and a fraction
+        map->interfaces[0].unitsPerSecond = magic == PCAP_MAGIC ? MICROSECONDS_IN_SECOND : 1000000000;
+        map->interfaceCount = 1;
+        return 0;
+    }
+
+    if (magic == PCAPNG_SECTION_HEADER) {
+        uint32_t byteOrder;
+        map->format = CAPTURE_PCAPNG;
+        _u32 length = capturePcapngLength(scan, 0);
+        if (length < PCAPNG_MIN_BLOCK + sizeof(byteOrder)) {
+            return -1;
+        }
+        memcpy(&byteOrder, &scan->base[sizeof(pcapngBlockHeader_t)], sizeof(byteOrder));
+        if (byteOrder != PCAPNG_BYTE_ORDER_MAGIC) {
+            return -1;
+        }
+        map->firstRecord = length;
+        return 0;
+    }
+    return -1;
+}
+
+_i32 captureMapOpen(captureMap_t *map, const char *path) {
+    memset(map, 0, sizeof(*map));
+
+    // The sniffer may still be appending to the capture, only what is there now is mapped
+    map->file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (map->file == INVALID_HANDLE_VALUE) {
+        DEBUG("[ERROR] Failed to open %s: %lu", path, GetLastError());
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(map->file, &size) || size.QuadPart == 0) {
+        DEBUG("[ERROR] %s is empty", path);
+        captureMapClose(map);
+        return -1;
+    }
+    map->size = size.QuadPart;
+
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    map->granularity = system.dwAllocationGranularity;
+
+    map->mapping = CreateFileMapping(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map->mapping == NULL) {
+        DEBUG("[ERROR] Failed to map %s: %lu", path, GetLastError());
+        captureMapClose(map);
+        return -1;
+    }
+    if (captureViewMap(map, &map->scan, 0, CAPTURE_SCAN_WINDOW) < 0) {
+        captureMapClose(map);
+        return -1;
+    }
+
+    if (captureMapDetect(map) < 0) {
+        DEBUG("[ERROR] %s is not a little-endian pcap or pcapng file", path);
+        captureMapClose(map);
+        return -1;
+    }
+    return 0;
+}
+
+void captureMapClose(captureMap_t *map) {
+    captureViewUnmap(&map->scan);
+    if (map->mapping != NULL) {
+        CloseHandle(map->mapping);
+        map->mapping = NULL;
+    }
+    if (map->file != INVALID_HANDLE_VALUE && map->file != NULL) {
+        CloseHandle(map->file);
+        map->file = NULL;
+    }
+}
+
+_i32 captureViewMap(const captureMap_t *map, captureView_t *view, uint64_t start, uint64_t end) {
+    if (end > map->size) {
+        end = map->size;
+    }
+    memset(view, 0, sizeof(*view));
+    if (start >= end) {
+        return -1;
+    }
+
+    view->start = start - start % map->granularity;
+    view->end = end;
+    view->base = MapViewOfFile(map->mapping, FILE_MAP_READ, (DWORD) (view->start >> 32),
+            (DWORD) view->start, (SIZE_T) (view->end - view->start));
+    if (view->base == NULL) {
+        DEBUG("[ERROR] Failed to map %llu bytes at %llu: %lu",
+                (unsigned long long) (view->end - view->start), (unsigned long long) view->start,
+                GetLastError());
+        memset(view, 0, sizeof(*view));
+        return -1;
+    }
+    return 0;
+}
+
+void captureViewUnmap(captureView_t *view) {
+    if (view->base != NULL) {
+        UnmapViewOfFile(view->base);
+    }
+    memset(view, 0, sizeof(*view));
+}
@@ -0,0 +1,93 @@
+#ifndef __CAPTURE_MAP_H__
+#define __CAPTURE_MAP_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+
+/*
+ * Read-only memory mapping of a pcap or pcapng capture. Records are decoded in place from views of
+ * the file: every range gets its own view, so any number of threads can walk disjoint ranges at the
+ * same time and a 32-bit build reads captures larger than its address space.
+ *
+ * Offsets always point at a pcap record header or a pcapng block. Only the scanner, a single thread
+ * walking the file front to back with captureMapSkip, learns the interfaces of a pcapng file; the
+ * ranges it hands out never contain a packet of an interface it has not seen yet. The scanner reads
+ * through a window of CAPTURE_SCAN_WINDOW bytes that slides along with it.
+ */
+#define CAPTURE_MAX_INTERFACES 16
+#define CAPTURE_MAX_RECORD (256 * 1024) /* largest snaplen of common writers */
+#define CAPTURE_MAX_BLOCK (CAPTURE_MAX_RECORD + 64 * 1024) /* larger pcapng blocks are corrupted */
+#define CAPTURE_SCAN_WINDOW (16 * 1024 * 1024) /* several CAPTURE_MAX_BLOCK */
+
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION 0x00000001
+#define PCAPNG_ENHANCED_PACKET 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPTION_END 0
+#define PCAPNG_OPTION_TSRESOL 9
+
+typedef enum
+{
+    CAPTURE_PCAP,
+    CAPTURE_PCAPNG,
+} e_CaptureFormat;
+
+typedef struct captureInterface {
+    uint16_t linkType;
+    uint64_t unitsPerSecond; /* of the timestamps */
+} captureInterface_t;
+
+typedef struct captureView {
+    const _u8 *base; /* of the mapped range [start, end) */
+    uint64_t start; /* multiple of the allocation granularity */
+    uint64_t end;
+} captureView_t;
+
+typedef struct captureMap {
+    HANDLE file;
+    HANDLE mapping;
+    uint64_t size;
+    _u32 granularity; /* of the view offsets */
+    e_CaptureFormat format;
+    uint64_t firstRecord; /* offset behind the file header */
+    captureView_t scan; /* window of captureMapSkip */
+    _u32 interfaceCount;
+    captureInterface_t interfaces[CAPTURE_MAX_INTERFACES];
+} captureMap_t;
+
+typedef struct captureRecord {
+    uint64_t timestampUs;
+    const _u8 *frame; /* 802.11 frame, NULL for blocks without a packet and unknown link types */
+    _u32 frameLength;
+    BOOL hasSignal;
+    _i8 signalDbm;
+} captureRecord_t;
+
+_i32 captureMapOpen(captureMap_t *map, const char *path);
+
+void captureMapClose(captureMap_t *map);
+
+// Maps the range [\p start, \p end) of the capture, the view starts at the granularity below \p start
+_i32 captureViewMap(const captureMap_t *map, captureView_t *view, uint64_t start, uint64_t end);
+
+void captureViewUnmap(captureView_t *view);
+
+/*!
+ \brief Steps over the record or block at \p offset, learning the interfaces of a pcapng file.
+
+ \return length of the record or block, 0 at the end of the capture or where it is truncated or
+ corrupted
+ */
+_u32 captureMapSkip(captureMap_t *map, uint64_t offset);
+
+/*!
+ \brief Decodes the record or block at \p offset, which has to lie in \p view.
+
+ \return length of the record or block, 0 at the end of the view or where it is truncated or
+ corrupted
+ */
+_u32 captureMapRead(const captureMap_t *map, const captureView_t *view, uint64_t offset,
+        captureRecord_t *record);
+
+#endif /* __CAPTURE_MAP_H__ */
@@ -0,0 +1,138 @@
+#include "main.h"
+
+#define END_OF_FILE UINT64_MAX
+
+typedef struct extractStats {
+    _u32 blocksRead;
+    _u32 blocksSkipped;
+    uint64_t recordsRead;
+    uint64_t recordsCopied;
+} extractStats_t;
+
+// Big enough for any record, kept out of the arena which is sized for the capture path
+static _u8 g_record[sizeof(pcapRecordHeader_t) + PCAP_SNAPLEN];
+
+static BOOL extractRecordMatches(const options_t *options, const _u8 *record) {
+    uint64_t timestampUs = pcapRecordTimestamp((const pcapRecordHeader_t *) record);
+    if (timestampUs < options->fromUs || timestampUs > options->toUs) {
+        return FALSE;
+    }
+    if (!options->hasAddress) {
+        return TRUE;
+    }
+
+    _u32 frameLength = 0;
+    const _u8 *frame = pcapRecordFrame(record, &frameLength);
+    ieee80211Frame_t parsed;
+    if (frame == NULL || ieee80211Parse(frame, frameLength, &parsed) < 0) {
+        return FALSE;
+    }
+    return ieee80211Carries(&parsed, options->address);
+}
+
+// Copies the matching records stored in [start, end) of the capture
+static _i32 extractRange(const options_t *options, FILE *capture, uint64_t start, uint64_t end,
+        output_t *out, extractStats_t *stats) {
+    if (_fseeki64(capture, start, SEEK_SET) != 0) {
+        DEBUG("[ERROR] Failed to seek to %llu", (unsigned long long) start);
+        return -1;
+    }
+
+    pcapRecordHeader_t *header = (pcapRecordHeader_t *) g_record;
+    uint64_t position = start;
+    while (position < end) {
+        if (fread(header, sizeof(*header), 1, capture) != 1) {
+            break;
+        }
+        if (header->incl_len > PCAP_SNAPLEN) {
+            DEBUG("[ERROR] Corrupted record at %llu", (unsigned long long) position);
+            return -1;
+        }
+        if (fread(&g_record[sizeof(*header)], 1, header->incl_len, capture) != header->incl_len) {
+            DEBUG("Truncated record at %llu", (unsigned long long) position);
+            break;
+        }
+
+        _u32 recordLength = sizeof(*header) + header->incl_len;
+        position += recordLength;
+        stats->recordsRead++;
+
+        if (extractRecordMatches(options, g_record)) {
+            _i32 retVal = outputWriteRecord(out, g_record, recordLength);
+            ASSERT_ON_ERROR(retVal);
+            stats->recordsCopied++;
+        }
+    }
+    return 0;
+}
+
+// Walks the sidecar index, returns the end of the indexed part of the capture
+static _i32 extractIndexed(const options_t *options, FILE *capture, output_t *out,
+        extractStats_t *stats, uint64_t *indexedEnd) {
+    // Too big for the stack of every caller
+    static captureIndexReader_t index;
+    if (!captureIndexReaderOpen(&index, options->inputPath)) {
+        return 0;
+    }
+
+    _i32 retVal = 0;
+    while (retVal == 0 && captureIndexReaderNext(&index)) {
+        uint64_t entryEnd = index.entry.offset + index.entry.length;
+        if (entryEnd > *indexedEnd) {
+            *indexedEnd = entryEnd;
+        }
+
+        if (!captureIndexReaderMatches(&index, options->fromUs, options->toUs,
+                options->hasAddress ? options->address : NULL)) {
+            stats->blocksSkipped++;
+            continue;
+        }
+        stats->blocksRead++;
+        retVal = extractRange(options, capture, index.entry.offset, entryEnd, out, stats);
+    }
+
+    captureIndexReaderClose(&index);
+    return retVal;
+}
+
+_i32 extractCapture(const options_t *options) {
+    FILE *capture = fopen(options->inputPath, "rb");
+    if (capture == NULL) {
+        DEBUG("[ERROR] Failed to open %s", options->inputPath);
+        return -1;
+    }
+
+    wireSharkGlobalHeader_t gHeader;
+    if (fread(&gHeader, sizeof(gHeader), 1, capture) != 1 || gHeader.magic_number != PCAP_MAGIC) {
+        DEBUG("[ERROR] %s is not a pcap file written by the sniffer", options->inputPath);
+        fclose(capture);
+        return -1;
+    }
+
+    output_t out;
+    captureIndex_t outIndex;
+    if (outputOpenFile(&out, options->outputPath, &outIndex) < 0
+            || outputWriteGlobalHeader(&out, &gHeader) < 0) {
+        fclose(capture);
+        return -1;
+    }
+
+    extractStats_t stats = { 0 };
+    uint64_t indexedEnd = sizeof(gHeader);
+    _i32 retVal = extractIndexed(options, capture, &out, &stats, &indexedEnd);
+
+    // Records written after the last index entry, or the whole capture when there is no index
+    if (retVal == 0) {
+        retVal = extractRange(options, capture, indexedEnd, END_OF_FILE, &out, &stats);
+    }
+
+    if (outputClose(&out) < 0) {
+        retVal = -1;
+    }
+    fclose(capture);
+
+    REPORT("Blocks read: %u, skipped: %u", stats.blocksRead, stats.blocksSkipped);
+    REPORT("Records read: %llu, copied: %llu", (unsigned long long) stats.recordsRead,
+            (unsigned long long) stats.recordsCopied);
+    return retVal;
+}
@@ -0,0 +1,18 @@
+#ifndef __EXTRACT_H__
+#define __EXTRACT_H__
+
+#include "simplelink.h"
+#include "options.h"
+
+/*!
+ \brief Copies the records of options->inputPath that fall into [fromUs, toUs] and, when given,
+ carry options->address into a new capture options->outputPath.
+
+ Only the blocks whose sidecar index entry matches are read. A capture without index, and the tail
+ of a capture that was not indexed yet, are scanned linearly.
+
+ \return 0 on success, negative on error
+ */
+_i32 extractCapture(const options_t *options);
+
+#endif /* __EXTRACT_H__ */
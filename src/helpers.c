@@ -12,6 +12,45 @@ void initClk()
 {
 }
 
+static volatile LONG g_stopRequested = FALSE;
+static volatile LONG g_reportRequested = FALSE;
+
+static BOOL WINAPI ctrlHandler(DWORD ctrlType)
+{
+    switch (ctrlType)
+    {
+    case CTRL_BREAK_EVENT:
+        InterlockedExchange(&g_reportRequested, TRUE);
+        return TRUE;
+    case CTRL_C_EVENT:
+        InterlockedExchange(&g_stopRequested, TRUE);
+        return TRUE;
+    case CTRL_CLOSE_EVENT:
+        // Windows ends the process as soon as this returns: wait here for main() to flush the
+        // output and exit, which ends this thread as well, or for the system to give up
+        InterlockedExchange(&g_stopRequested, TRUE);
+        Sleep(INFINITE);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+void installCtrlHandler()
+{
+    SetConsoleCtrlHandler(ctrlHandler, TRUE);
+}
+
+BOOL isStopRequested()
+{
+    return g_stopRequested;
+}
+
+BOOL takeReportRequest()
+{
+    return InterlockedExchange(&g_reportRequested, FALSE);
+}
+
 void displayVersion()
 {
     SlVersionFull ver = { 0 };
@@ -37,6 +37,9 @@ typedef enum
 #define DEBUG(Fmt, ...)
 #endif
 
+// Reports are printed in release builds as well
+#define REPORT(FORMAT_STR, ...) fprintf(stderr, "[CC3100] " FORMAT_STR "\n", ##__VA_ARGS__)
+
 #define RUN(call)            \
     do                       \
     {                        \
@@ -48,4 +51,10 @@ void stopWDT();
 void initClk();
 void _SlNonOsMainLoopTask(void);
 void displayVersion();
+
+// Ctrl+Break asks for a statistics report, Ctrl+C and closing the console ask to stop; closing the
+// console waits until the process has exited on its own
+void installCtrlHandler();
+BOOL isStopRequested();
+BOOL takeReportRequest();
 #endif /* __HELPERS_H__ */
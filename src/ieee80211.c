@@ -0,0 +1,99 @@
+#include "main.h"
+
+#define FRAME_CONTROL_LENGTH 2
+#define DURATION_LENGTH 2
+#define SEQUENCE_CONTROL_LENGTH 2
+#define QOS_CONTROL_LENGTH 2
+#define IEEE80211_SUBTYPE_QOS_FLAG 0x08
+
+_i32 ieee80211Parse(const _u8 *frame, _u32 length, ieee80211Frame_t *parsed) {
+    memset(parsed, 0, sizeof(*parsed));
+
+    const _u32 ADDR1_OFFSET = FRAME_CONTROL_LENGTH + DURATION_LENGTH;
+    const _u32 ADDR2_OFFSET = ADDR1_OFFSET + IEEE80211_ADDRESS_LENGTH;
+    const _u32 ADDR3_OFFSET = ADDR2_OFFSET + IEEE80211_ADDRESS_LENGTH;
+    const _u32 HEADER_LENGTH = ADDR3_OFFSET + IEEE80211_ADDRESS_LENGTH + SEQUENCE_CONTROL_LENGTH;
+
+    if (length < ADDR1_OFFSET + IEEE80211_ADDRESS_LENGTH) {
+        return -1;
+    }
+
+    parsed->type = (frame[0] >> 2) & 0x03;
+    parsed->subtype = (frame[0] >> 4) & 0x0F;
+    parsed->toDs = (frame[1] & 0x01) != 0;
+    parsed->fromDs = (frame[1] & 0x02) != 0;
+    parsed->addr1 = &frame[ADDR1_OFFSET];
+
+    if (parsed->type == IEEE80211_TYPE_CONTROL) {
+        // ACK and CTS carry the receiver only, the rest of the control frames add the transmitter
+        if (length >= ADDR2_OFFSET + IEEE80211_ADDRESS_LENGTH) {
+            parsed->addr2 = &frame[ADDR2_OFFSET];
+        }
+        return 0;
+    }
+
+    if (length < HEADER_LENGTH) {
+        return -1;
+    }
+    parsed->addr2 = &frame[ADDR2_OFFSET];
+    parsed->addr3 = &frame[ADDR3_OFFSET];
+
+    _u32 headerLength = HEADER_LENGTH;
+    if (parsed->type == IEEE80211_TYPE_DATA) {
+        if (parsed->toDs && parsed->fromDs) {
+            headerLength += IEEE80211_ADDRESS_LENGTH;
+        }
+        if (parsed->subtype & IEEE80211_SUBTYPE_QOS_FLAG) {
+            headerLength += QOS_CONTROL_LENGTH;
+        }
+
+        if (!parsed->toDs && !parsed->fromDs) {
+            parsed->bssid = parsed->addr3;
+        } else if (parsed->toDs && !parsed->fromDs) {
+            parsed->bssid = parsed->addr1;
+        } else if (!parsed->toDs && parsed->fromDs) {
+            parsed->bssid = parsed->addr2;
+        }
+    } else {
+        parsed->bssid = parsed->addr3;
+    }
+
+    if (length >= headerLength) {
+        parsed->body = &frame[headerLength];
+        parsed->bodyLength = length - headerLength;
+    }
+    return 0;
+}
+
+_i32 ieee80211ParseAddress(const char *text, _u8 *address) {
+    unsigned int octets[IEEE80211_ADDRESS_LENGTH];
+    char trailing;
+
+    int parsed = sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x%c", &octets[0], &octets[1], &octets[2],
+            &octets[3], &octets[4], &octets[5], &trailing);
+    if (parsed != IEEE80211_ADDRESS_LENGTH) {
+        return -1;
+    }
+
+    for (int i = 0; i < IEEE80211_ADDRESS_LENGTH; i++) {
+        address[i] = (_u8) octets[i];
+    }
+    return 0;
+}
+
+BOOL ieee80211AddressIs(const _u8 *candidate, const _u8 *address) {
+    return candidate != NULL && memcmp(candidate, address, IEEE80211_ADDRESS_LENGTH) == 0;
+}
+
+BOOL ieee80211Carries(const ieee80211Frame_t *parsed, const _u8 *address) {
+    return ieee80211AddressIs(parsed->addr1, address) || ieee80211AddressIs(parsed->addr2, address)
+            || ieee80211AddressIs(parsed->addr3, address);
+}
+
+uint64_t ieee80211AddressHash(const _u8 *address, uint64_t hash) {
+    for (int i = 0; i < IEEE80211_ADDRESS_LENGTH; i++) {
+        hash ^= address[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,55 @@
+#ifndef __IEEE80211_H__
+#define __IEEE80211_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+
+#define IEEE80211_ADDRESS_LENGTH 6
+#define IEEE80211_HASH_SEED 0xCBF29CE484222325ULL /* FNV-1a offset basis */
+
+#define IEEE80211_TYPE_MANAGEMENT 0
+#define IEEE80211_TYPE_CONTROL 1
+#define IEEE80211_TYPE_DATA 2
+
+#define IEEE80211_SUBTYPE_ASSOC_RESPONSE 1
+#define IEEE80211_SUBTYPE_REASSOC_RESPONSE 3
+#define IEEE80211_SUBTYPE_BEACON 8
+#define IEEE80211_SUBTYPE_DISASSOC 10
+#define IEEE80211_SUBTYPE_AUTH 11
+#define IEEE80211_SUBTYPE_DEAUTH 12
+
+// The fields of an 802.11 MAC header, addresses that the frame does not carry are NULL
+typedef struct ieee80211Frame {
+    _u8 type;
+    _u8 subtype;
+    BOOL toDs;
+    BOOL fromDs;
+    const _u8 *addr1; /* receiver */
+    const _u8 *addr2; /* transmitter */
+    const _u8 *addr3;
+    const _u8 *bssid;
+    const _u8 *body; /* frame body after the MAC header */
+    _u32 bodyLength;
+} ieee80211Frame_t;
+
+/*!
+ \brief Parses the MAC header of an 802.11 frame
+
+ \return 0 on success, negative when the frame is too short for its type
+ */
+_i32 ieee80211Parse(const _u8 *frame, _u32 length, ieee80211Frame_t *parsed);
+
+// Parses "aa:bb:cc:dd:ee:ff", returns negative on malformed input
+_i32 ieee80211ParseAddress(const char *text, _u8 *address);
+
+// TRUE when \p candidate, which may be NULL, is \p address
+BOOL ieee80211AddressIs(const _u8 *candidate, const _u8 *address);
+
+// TRUE when \p address is the receiver, transmitter or third address of the frame
+BOOL ieee80211Carries(const ieee80211Frame_t *parsed, const _u8 *address);
+
+// FNV-1a of \p address, continuing \p hash, which starts as IEEE80211_HASH_SEED
+uint64_t ieee80211AddressHash(const _u8 *address, uint64_t hash);
+
+#endif /* __IEEE80211_H__ */
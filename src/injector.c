@@ -0,0 +1,260 @@
+#include "main.h"
+
+#include <mmsystem.h> /* timeBeginPeriod */
+
+#define SEQUENCE_CONTROL_OFFSET 22
+#define MAC_HEADER_LENGTH 24
+#define TX_POWER_MAX 0
+#define TX_SHORT_PREAMBLE 1
+#define SIMULATED_RSSI -40
+
+typedef struct deviceTransport {
+    _i16 sockId;
+    _i16 channel;
+} deviceTransport_t;
+
+// Stand-in for the CC3100: every frame "sent" is delivered to the probe accounting of a capture
+typedef struct simulatedDevice {
+    const injectConfig_t *config;
+    _i16 channel;
+    _u8 *buffer;
+    uint32_t random;
+    probeStats_t probes;
+    uint64_t dropped;
+    uint64_t duplicated;
+} simulatedDevice_t;
+
+static const _u8 DEFAULT_TRANSMITTER[IEEE80211_ADDRESS_LENGTH] = { 0x02, 0xCC, 0x31, 0x00, 0x00, 0x01 };
+
+static _i32 injectDeviceSend(void *context, const _u8 *frame, _u32 length) {
+    deviceTransport_t *device = context;
+    _i16 retVal = sl_Send(device->sockId, frame, length,
+            SL_RAW_RF_TX_PARAMS(device->channel, RATE_1M, TX_POWER_MAX, TX_SHORT_PREAMBLE));
+    if (retVal < 0) {
+        DEBUG("[ERROR] Send: %d", retVal);
+    }
+    return retVal;
+}
+
+// xorshift32, deterministic so a simulated run can be repeated
+static double simulatedPercent(simulatedDevice_t *device) {
+    device->random ^= device->random << 13;
+    device->random ^= device->random >> 17;
+    device->random ^= device->random << 5;
+    return device->random * 100.0 / UINT32_MAX;
+}
+
+static _i32 injectSimulatedSend(void *context, const _u8 *frame, _u32 length) {
+    simulatedDevice_t *device = context;
+
+    if (simulatedPercent(device) < device->config->simulateLoss) {
+        device->dropped++;
+        return length;
+    }
+
+    latencyTick_t arrival = latencyNow();
+    _u32 recordLength = 0;
+    memcpy(&device->buffer[PCAP_RECORD_HEADROOM], frame, length);
+    _u8 *record = pcapWrapFrame(&device->buffer[PCAP_RECORD_HEADROOM], length,
+            latencyTicksToMicroseconds(arrival), SIMULATED_RSSI, device->channel, &recordLength);
+
+    probeObserve(&device->probes, record, arrival);
+    if (simulatedPercent(device) < device->config->simulateDuplicates) {
+        probeObserve(&device->probes, record, latencyNow());
+        device->duplicated++;
+    }
+    return length;
+}
+
+static _i32 injectLoadTemplate(const char *path, _u8 *frame, _u32 *length) {
+    static _u8 record[sizeof(pcapRecordHeader_t) + PCAP_SNAPLEN];
+
+    FILE *capture = fopen(path, "rb");
+    if (capture == NULL) {
+        DEBUG("[ERROR] Failed to open %s", path);
+        return -1;
+    }
+
+    wireSharkGlobalHeader_t gHeader;
+    pcapRecordHeader_t *header = (pcapRecordHeader_t *) record;
+    BOOL loaded = fread(&gHeader, sizeof(gHeader), 1, capture) == 1
+            && gHeader.magic_number == PCAP_MAGIC
+            && gHeader.network == LINKTYPE_IEEE802_11_RADIOTAP
+            && fread(header, sizeof(*header), 1, capture) == 1 && header->incl_len <= PCAP_SNAPLEN
+            && fread(header + 1, 1, header->incl_len, capture) == header->incl_len;
+    fclose(capture);
+
+    if (!loaded) {
+        DEBUG("[ERROR] %s has no radiotap record", path);
+        return -1;
+    }
+
+    const _u8 *templateFrame = pcapRecordFrame(record, length);
+    if (templateFrame == NULL || *length > CAPTURE_MTU - sizeof(SlTransceiverRxOverHead_t)) {
+        DEBUG("[ERROR] The first record of %s can not be injected", path);
+        return -1;
+    }
+    memcpy(frame, templateFrame, *length);
+    return 0;
+}
+
+static void injectDefaultTemplate(_u32 size, _u8 *frame, _u32 *length) {
+    memset(frame, 0, size);
+
+    frame[0] = IEEE80211_TYPE_DATA << 2;
+    memset(&frame[4], 0xFF, IEEE80211_ADDRESS_LENGTH);
+    memcpy(&frame[4 + IEEE80211_ADDRESS_LENGTH], DEFAULT_TRANSMITTER, IEEE80211_ADDRESS_LENGTH);
+    memcpy(&frame[4 + 2 * IEEE80211_ADDRESS_LENGTH], DEFAULT_TRANSMITTER, IEEE80211_ADDRESS_LENGTH);
+
+    for (_u32 i = MAC_HEADER_LENGTH; i < size; i++) {
+        frame[i] = (_u8) i;
+    }
+    *length = size;
+}
+
+// Prepares the frame to inject, returns the offset of the probe inside it
+static _i32 injectBuildTemplate(const injectConfig_t *config, _u8 *frame, _u32 *length,
+        _u32 *probeOffset) {
+    const _u32 MAX_LENGTH = CAPTURE_MTU - sizeof(SlTransceiverRxOverHead_t);
+
+    if (config->templatePath != NULL) {
+        _i32 retVal = injectLoadTemplate(config->templatePath, frame, length);
+        ASSERT_ON_ERROR(retVal);
+    } else {
+        _u32 size = config->size;
+        if (size < MAC_HEADER_LENGTH + sizeof(probe_t)) {
+            size = MAC_HEADER_LENGTH + sizeof(probe_t);
+        }
+        if (size > MAX_LENGTH) {
+            size = MAX_LENGTH;
+        }
+        injectDefaultTemplate(size, frame, length);
+    }
+
+    ieee80211Frame_t parsed;
+    if (ieee80211Parse(frame, *length, &parsed) < 0 || parsed.type != IEEE80211_TYPE_DATA
+            || parsed.body == NULL) {
+        DEBUG("[ERROR] The template has to be a data frame");
+        return -1;
+    }
+
+    *probeOffset = parsed.body - frame;
+    if (parsed.bodyLength < sizeof(probe_t)) {
+        if (*probeOffset + sizeof(probe_t) > MAX_LENGTH) {
+            DEBUG("[ERROR] The template leaves no room for the probe");
+            return -1;
+        }
+        *length = *probeOffset + sizeof(probe_t);
+    }
+    return 0;
+}
+
+static void injectWaitUntil(latencyTick_t target) {
+    latencyTick_t now = latencyNow();
+    while (now < target) {
+        uint64_t remainingUs = latencyTicksToMicroseconds(target - now);
+        if (remainingUs > INJECT_SPIN_US) {
+            Sleep((remainingUs - INJECT_SPIN_US) / 1000);
+        } else {
+            YieldProcessor();
+        }
+        now = latencyNow();
+    }
+}
+
+static _i32 injectRun(const injectConfig_t *config, injectTransport_t *transport, _u8 *frame,
+        _u32 length, _u32 probeOffset) {
+    const uint32_t run = (uint32_t) latencyNow();
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+
+    installCtrlHandler();
+    timeBeginPeriod(1);
+
+    latencyTick_t start = latencyNow();
+    for (_u32 sequence = 0; sequence < config->count && !isStopRequested(); sequence++) {
+        latencyTick_t now = latencyNow();
+        if (config->rate != 0) {
+            latencyTick_t target = start
+                    + latencyMicrosecondsToTicks((uint64_t) sequence * MICROSECONDS_IN_SECOND
+                            / config->rate);
+            injectWaitUntil(target);
+            now = latencyNow();
+            latencyRecord(LATENCY_PACING, target, now);
+        }
+
+        // 802.11 sequence number, the fragment number stays 0
+        _u16 sequenceControl = (_u16) (sequence << 4);
+        memcpy(&frame[SEQUENCE_CONTROL_OFFSET], &sequenceControl, sizeof(sequenceControl));
+        probeStamp(&frame[probeOffset], run, sequence, now);
+
+        if (transport->send(transport->context, frame, length) < 0) {
+            failed++;
+        } else {
+            sent++;
+        }
+        latencyRecord(LATENCY_SEND, now, latencyNow());
+
+        if (takeReportRequest()) {
+            latencyReport();
+        }
+    }
+
+    timeEndPeriod(1);
+
+    uint64_t elapsedUs = latencyTicksToMicroseconds(latencyNow() - start);
+    REPORT("Injected %llu frames of %u bytes (%llu failed) in %.3f s, %.1f frames/s",
+            (unsigned long long) sent, length, (unsigned long long) failed,
+            elapsedUs / (double) MICROSECONDS_IN_SECOND,
+            elapsedUs != 0 ? sent * (double) MICROSECONDS_IN_SECOND / elapsedUs : 0.0);
+    latencyReport();
+    return failed == 0 ? 0 : -1;
+}
+
+_i32 injectTraffic(const injectConfig_t *config, _i16 channel) {
+    _u8 *frame = arenaAlloc(ARENA_INJECT, CAPTURE_MTU);
+    if (frame == NULL || latencyInit() < 0) {
+        return -1;
+    }
+
+    _u32 length = 0;
+    _u32 probeOffset = 0;
+    _i32 retVal = injectBuildTemplate(config, frame, &length, &probeOffset);
+    ASSERT_ON_ERROR(retVal);
+
+    if (config->simulate) {
+        static simulatedDevice_t device;
+        device.config = config;
+        device.channel = channel;
+        device.random = 0x2545F491;
+        device.buffer = arenaAlloc(ARENA_INJECT, PCAP_RECORD_HEADROOM + CAPTURE_MTU);
+        if (device.buffer == NULL) {
+            return -1;
+        }
+        arenaSeal();
+
+        injectTransport_t transport = { injectSimulatedSend, &device };
+        retVal = injectRun(config, &transport, frame, length, probeOffset);
+
+        REPORT("Simulated device dropped %llu and duplicated %llu frames",
+                (unsigned long long) device.dropped, (unsigned long long) device.duplicated);
+        probeReport(&device.probes);
+        return retVal;
+    }
+
+    deviceTransport_t device = {
+            .sockId = sl_Socket(SL_AF_RF, SL_SOCK_RAW, channel),
+            .channel = channel,
+    };
+    if (device.sockId < 0) {
+        DEBUG("Can not create socket: %d", device.sockId);
+        return -1;
+    }
+    arenaSeal();
+
+    injectTransport_t transport = { injectDeviceSend, &device };
+    retVal = injectRun(config, &transport, frame, length, probeOffset);
+
+    sl_Close(device.sockId);
+    return retVal;
+}
@@ -0,0 +1,40 @@
+#ifndef __INJECTOR_H__
+#define __INJECTOR_H__
+
+#include "simplelink.h"
+
+/*
+ * Traffic generator: injects copies of a template frame through sl_Send on the transceiver socket
+ * at a fixed rate, stamping a probe (see probe.h) into each copy so that a capture can count loss,
+ * duplication and delay.
+ *
+ * Frames leave on an absolute schedule, start + n / rate, so a late frame does not delay the ones
+ * after it: the generator sleeps while the next slot is more than INJECT_SPIN_US away and spins for
+ * the rest.
+ */
+#define INJECT_SPIN_US 2000
+#define INJECT_DEFAULT_SIZE 100 /* octets of the default frame, MAC header included */
+#define INJECT_DEFAULT_COUNT 1000
+
+typedef struct injectConfig {
+    _u32 rate; /* frames per second, 0 sends as fast as possible */
+    _u32 count;
+    _u32 size; /* of the default frame */
+    const char *templatePath; /* pcap whose first record is used as the template, NULL for default */
+    BOOL simulate; /* send to a stand-in device that feeds the probe accounting directly */
+    double simulateLoss; /* percent of the frames the stand-in drops */
+    double simulateDuplicates; /* percent of the frames the stand-in delivers twice */
+} injectConfig_t;
+
+// Sends one 802.11 frame, negative on error
+typedef _i32 (*injectSend_t)(void *context, const _u8 *frame, _u32 length);
+
+typedef struct injectTransport {
+    injectSend_t send;
+    void *context;
+} injectTransport_t;
+
+// Injects config->count frames on \p channel, through the device or the simulated stand-in
+_i32 injectTraffic(const injectConfig_t *config, _i16 channel);
+
+#endif /* __INJECTOR_H__ */
@@ -0,0 +1,159 @@
+#include "main.h"
+
+#define SUB_BUCKET_COUNT (1 << LATENCY_SUB_BUCKET_BITS)
+#define NANOSECONDS_IN_SECOND 1000000000ULL
+
+typedef struct latencyHistogram {
+    uint64_t total;
+    uint64_t max;
+    uint32_t counts[LATENCY_BUCKET_COUNT];
+} latencyHistogram_t;
+
+typedef struct latencyState {
+    latencyHistogram_t stages[LATENCY_STAGE_COUNT];
+    int64_t deviceOffsetFloorUs; /* smallest host - device offset seen */
+    BOOL deviceSeen;
+} latencyState_t;
+
+static const char * const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+        [LATENCY_RECV] = "recv",
+        [LATENCY_BUILD] = "build",
+        [LATENCY_WRITE] = "write",
+        [LATENCY_DEVICE_TO_HOST] = "device->host",
+        [LATENCY_PROBE] = "probe",
+        [LATENCY_SEND] = "send",
+        [LATENCY_PACING] = "pacing",
+};
+
+static uint64_t g_ticksPerSecond = 0;
+static __thread latencyState_t *t_latency = NULL;
+
+static int latencyMostSignificantBit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+static _u32 latencyBucket(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return (_u32) value;
+    }
+    if (value >= (1ULL << LATENCY_MAX_BITS)) {
+        value = (1ULL << LATENCY_MAX_BITS) - 1;
+    }
+
+    int shift = latencyMostSignificantBit(value) - LATENCY_SUB_BUCKET_BITS;
+    return ((shift + 1) << LATENCY_SUB_BUCKET_BITS) + (_u32) (value >> shift) - SUB_BUCKET_COUNT;
+}
+
+// Highest value that falls into the bucket
+static uint64_t latencyBucketValue(_u32 bucket) {
+    _u32 group = bucket >> LATENCY_SUB_BUCKET_BITS;
+    if (group == 0) {
+        return bucket;
+    }
+
+    uint64_t base = (uint64_t) ((bucket & (SUB_BUCKET_COUNT - 1)) + SUB_BUCKET_COUNT) << (group - 1);
+    return base + (1ULL << (group - 1)) - 1;
+}
+
+static void latencyRecordValue(e_LatencyStage stage, uint64_t nanoseconds) {
+    if (t_latency == NULL) {
+        return;
+    }
+
+    latencyHistogram_t *histogram = &t_latency->stages[stage];
+    histogram->counts[latencyBucket(nanoseconds)]++;
+    histogram->total++;
+    if (nanoseconds > histogram->max) {
+        histogram->max = nanoseconds;
+    }
+}
+
+static uint64_t latencyTicksToNanoseconds(latencyTick_t ticks) {
+    return ticks / g_ticksPerSecond * NANOSECONDS_IN_SECOND
+            + ticks % g_ticksPerSecond * NANOSECONDS_IN_SECOND / g_ticksPerSecond;
+}
+
+static uint64_t latencyPercentile(const latencyHistogram_t *histogram, double percentile) {
+    uint64_t rank = (uint64_t) (histogram->total * percentile / 100.0 + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (_u32 bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            uint64_t value = latencyBucketValue(bucket);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+_i32 latencyInit() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    g_ticksPerSecond = frequency.QuadPart;
+
+    t_latency = arenaAlloc(ARENA_LATENCY, sizeof(latencyState_t));
+    if (t_latency == NULL) {
+        return -1;
+    }
+    return 0;
+}
+
+latencyTick_t latencyNow() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+uint64_t latencyTicksToMicroseconds(latencyTick_t ticks) {
+    return latencyTicksToNanoseconds(ticks) / 1000;
+}
+
+latencyTick_t latencyMicrosecondsToTicks(uint64_t microseconds) {
+    return microseconds / MICROSECONDS_IN_SECOND * g_ticksPerSecond
+            + microseconds % MICROSECONDS_IN_SECOND * g_ticksPerSecond / MICROSECONDS_IN_SECOND;
+}
+
+void latencyRecord(e_LatencyStage stage, latencyTick_t start, latencyTick_t end) {
+    latencyRecordValue(stage, end > start ? latencyTicksToNanoseconds(end - start) : 0);
+}
+
+void latencyRecordDevice(uint64_t deviceTimestampUs, latencyTick_t arrival) {
+    if (t_latency == NULL) {
+        return;
+    }
+
+    int64_t hostUs = latencyTicksToMicroseconds(arrival);
+    int64_t offsetUs = hostUs - (int64_t) deviceTimestampUs;
+
+    if (!t_latency->deviceSeen || offsetUs < t_latency->deviceOffsetFloorUs) {
+        t_latency->deviceOffsetFloorUs = offsetUs;
+        t_latency->deviceSeen = TRUE;
+    }
+    latencyRecordValue(LATENCY_DEVICE_TO_HOST,
+            (uint64_t) (offsetUs - t_latency->deviceOffsetFloorUs) * 1000);
+}
+
+void latencyReport() {
+    if (t_latency == NULL) {
+        return;
+    }
+
+    REPORT("Latency, microseconds:");
+    REPORT("  %-12s %10s %10s %10s %10s %10s", "stage", "count", "p50", "p99", "p99.9", "max");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        const latencyHistogram_t *histogram = &t_latency->stages[stage];
+        if (histogram->total == 0) {
+            continue;
+        }
+        REPORT("  %-12s %10llu %10.1f %10.1f %10.1f %10.1f", STAGE_NAMES[stage],
+                (unsigned long long) histogram->total,
+                latencyPercentile(histogram, 50.0) / 1000.0,
+                latencyPercentile(histogram, 99.0) / 1000.0,
+                latencyPercentile(histogram, 99.9) / 1000.0,
+                histogram->max / 1000.0);
+    }
+}
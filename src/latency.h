@@ -0,0 +1,63 @@
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+
+/*
+ * Log-bucketed (HDR-style) latency histograms for the stages of the capture loop.
+ * Every power of two is split into 2^LATENCY_SUB_BUCKET_BITS linear buckets, so a reported
+ * percentile is within 1 / 2^LATENCY_SUB_BUCKET_BITS of the real value. Values are kept in
+ * nanoseconds and clamped to 2^LATENCY_MAX_BITS (about 17 s).
+ *
+ * Histograms belong to the thread that called latencyInit(): recording neither allocates nor locks.
+ * They come from the arena, 4 * LATENCY_BUCKET_COUNT bytes per stage: about 14 KB with the defaults.
+ */
+#ifndef LATENCY_SUB_BUCKET_BITS
+#define LATENCY_SUB_BUCKET_BITS 4 /* percentiles within 6.25% */
+#endif
+#ifndef LATENCY_MAX_BITS
+#define LATENCY_MAX_BITS 34
+#endif
+#define LATENCY_BUCKET_COUNT ((LATENCY_MAX_BITS - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS)
+
+typedef enum
+{
+    LATENCY_RECV, /* blocked in sl_Recv */
+    LATENCY_BUILD, /* wrapping the frame into a pcap record */
+    LATENCY_WRITE, /* handing the record to the output, WriteFile included */
+    LATENCY_DEVICE_TO_HOST, /* radio timestamp to arrival, relative to the fastest frame seen */
+    LATENCY_PROBE, /* injected frame from sl_Send to arrival, see probe.h */
+    LATENCY_SEND, /* blocked in sl_Send */
+    LATENCY_PACING, /* how late a frame was injected compared to its schedule */
+
+    LATENCY_STAGE_COUNT
+} e_LatencyStage;
+
+typedef uint64_t latencyTick_t;
+
+// Allocates the histograms of the calling thread from the arena
+_i32 latencyInit();
+
+// Monotonic QueryPerformanceCounter ticks
+latencyTick_t latencyNow();
+
+uint64_t latencyTicksToMicroseconds(latencyTick_t ticks);
+latencyTick_t latencyMicrosecondsToTicks(uint64_t microseconds);
+
+void latencyRecord(e_LatencyStage stage, latencyTick_t start, latencyTick_t end);
+
+/*!
+ \brief Records how long a frame travelled from the radio to the host.
+
+ The device clock is not synchronized with the host, so the smallest (host - device) offset seen so
+ far is taken as the transport floor and every frame is recorded relative to it.
+ \p deviceTimestampUs is the radio clock extended by pcapClockExtend().
+ */
+void latencyRecordDevice(uint64_t deviceTimestampUs, latencyTick_t arrival);
+
+// Prints p50/p99/p99.9/max of every stage of the calling thread
+void latencyReport();
+
+#endif /* __LATENCY_H__ */
@@ -4,6 +4,25 @@
 int main(int argc, char** argv) {
     _i32 retVal = -1;
 
+    options_t options;
+    if (parseOptions(argc, argv, &options) < 0) {
+        displayUsage();
+        return -1;
+    }
+
+    if (options.command == COMMAND_EXTRACT) {
+        return extractCapture(&options) < 0 ? -1 : 0;
+    }
+    if (options.command == COMMAND_SHM_DUMP) {
+        return dumpSharedMemory(&options) < 0 ? -1 : 0;
+    }
+    if (options.command == COMMAND_ANALYZE) {
+        return analyzeCapture(&options) < 0 ? -1 : 0;
+    }
+    if (options.command == COMMAND_INJECT && options.inject.simulate) {
+        return injectTraffic(&options.inject, options.channel) < 0 ? -1 : 0;
+    }
+
     retVal = configureSimpleLinkToDefaultState();
     if (retVal < 0) {
         DEBUG(" Failed to configure the device in its default state");
@@ -45,10 +64,15 @@ int main(int argc, char** argv) {
         // already disconnected
     }
     DEBUG("Connection policy is cleared and CC3100 has been disconnected");
+
+    if (options.command == COMMAND_INJECT) {
+        DEBUG("Start injecting");
+        return injectTraffic(&options.inject, options.channel) < 0 ? -1 : 0;
+    }
+
     DEBUG("Start sniffing");
 
-    const _i16 channel = 10; // 1-13
-    retVal = sniffByWireshark(channel);
+    retVal = sniffByWireshark(&options);
     if (retVal < 0) {
         DEBUG("ERROR:sniffByWireshark");
         return -1;
@@ -2,14 +2,34 @@
 #define __MAIN_H__
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "simplelink.h"
 #include "sl_common.h"
 
 #include "helpers.h"
 #include "event_handlers.h"
+#include "arena.h"
+#include "pcap.h"
+#include "output.h"
+#include "latency.h"
+#include "ieee80211.h"
+#include "capture_index.h"
+#include "trigger.h"
+#include "shaping.h"
+#include "extract.h"
+#include "shm_ring.h"
+#include "shm_producer.h"
+#include "shm_consumer.h"
+#include "shm_dump.h"
+#include "probe.h"
+#include "injector.h"
+#include "capture_map.h"
+#include "work_pool.h"
+#include "analyze.h"
+#include "options.h"
 
-int sniffer(_i16 channel);
+int sniffByWireshark(const options_t *options);
 
 // global variables
 #ifndef __MAIN_C__
@@ -0,0 +1,225 @@
+#include "main.h"
+
+static BOOL optionIs(const char *arg, const char *name) {
+    return strcmp(arg, name) == 0;
+}
+
+static _i32 parseSeconds(const char *text, uint64_t *us) {
+    char *end = NULL;
+    double seconds = strtod(text, &end);
+    if (end == text || *end != '\0' || seconds < 0) {
+        DEBUG("[ERROR] Invalid time: %s", text);
+        return -1;
+    }
+    *us = (uint64_t) (seconds * MICROSECONDS_IN_SECOND);
+    return 0;
+}
+
+static _i32 parseCount(const char *text, _u32 *count) {
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value > UINT32_MAX) {
+        DEBUG("[ERROR] Invalid number: %s", text);
+        return -1;
+    }
+    *count = (_u32) value;
+    return 0;
+}
+
+static _i32 parsePercent(const char *text, double *percent) {
+    char *end = NULL;
+    *percent = strtod(text, &end);
+    if (end == text || *end != '\0' || *percent < 0 || *percent > 100) {
+        DEBUG("[ERROR] Invalid percentage: %s", text);
+        return -1;
+    }
+    return 0;
+}
+
+static _i32 parseTrigger(const char *text, triggerConfig_t *trigger) {
+    _u8 address[IEEE80211_ADDRESS_LENGTH];
+    if (strcmp(text, "deauth") == 0) {
+        trigger->conditions |= TRIGGER_DEAUTH_FLOOD;
+    } else if (strcmp(text, "assoc") == 0) {
+        trigger->conditions |= TRIGGER_ASSOC_FAILURE;
+    } else if (ieee80211ParseAddress(text, address) == 0) {
+        if (trigger->addressCount == TRIGGER_MAX_ADDRESSES) {
+            DEBUG("[ERROR] At most %u address triggers", TRIGGER_MAX_ADDRESSES);
+            return -1;
+        }
+        memcpy(trigger->addresses[trigger->addressCount++], address, IEEE80211_ADDRESS_LENGTH);
+        trigger->conditions |= TRIGGER_ADDRESS;
+    } else {
+        DEBUG("[ERROR] Unknown trigger: %s", text);
+        return -1;
+    }
+    return 0;
+}
+
+_i32 parseOptions(int argc, char **argv, options_t *options) {
+    memset(options, 0, sizeof(*options));
+    options->command = COMMAND_SNIFF;
+    options->channel = DEFAULT_CHANNEL;
+    options->toUs = UINT64_MAX;
+    options->ringName = SHM_RING_NAME;
+    options->trigger.preUs = TRIGGER_DEFAULT_PRE_SECONDS * MICROSECONDS_IN_SECOND;
+    options->trigger.postUs = TRIGGER_DEFAULT_POST_SECONDS * MICROSECONDS_IN_SECOND;
+    options->inject.count = INJECT_DEFAULT_COUNT;
+    options->inject.size = INJECT_DEFAULT_SIZE;
+
+    int i = 1;
+    if (i < argc && optionIs(argv[i], "extract")) {
+        options->command = COMMAND_EXTRACT;
+        if (argc < i + 3) {
+            return -1;
+        }
+        options->inputPath = argv[i + 1];
+        options->outputPath = argv[i + 2];
+        i += 3;
+    } else if (i < argc && optionIs(argv[i], "shm-dump")) {
+        options->command = COMMAND_SHM_DUMP;
+        if (argc < i + 2) {
+            return -1;
+        }
+        options->outputPath = argv[i + 1];
+        i += 2;
+    } else if (i < argc && optionIs(argv[i], "analyze")) {
+        options->command = COMMAND_ANALYZE;
+        if (argc < i + 2) {
+            return -1;
+        }
+        options->inputPath = argv[i + 1];
+        i += 2;
+    } else if (i < argc && optionIs(argv[i], "inject")) {
+        options->command = COMMAND_INJECT;
+        i++;
+    }
+
+    for (; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        _i32 retVal = 0;
+
+        if (options->command == COMMAND_SNIFF && optionIs(arg, "-shm")) {
+            options->sharedMemory = TRUE;
+            continue;
+        }
+        if (options->command == COMMAND_INJECT && optionIs(arg, "-simulate")) {
+            options->inject.simulate = TRUE;
+            continue;
+        }
+
+        if (value == NULL) {
+            DEBUG("[ERROR] Missing value of %s", arg);
+            return -1;
+        }
+
+        if ((options->command == COMMAND_SNIFF || options->command == COMMAND_INJECT)
+                && optionIs(arg, "-c")) {
+            options->channel = atoi(value);
+            if (options->channel < 1 || options->channel > 13) {
+                DEBUG("[ERROR] Channel must be 1-13");
+                return -1;
+            }
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-w")) {
+            options->outputPath = value;
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-trigger")) {
+            retVal = parseTrigger(value, &options->trigger);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-pre")) {
+            retVal = parseSeconds(value, &options->trigger.preUs);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-post")) {
+            retVal = parseSeconds(value, &options->trigger.postUs);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-sample")) {
+            retVal = parseCount(value, &options->shaping.sampleEvery);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-flow-sample")) {
+            retVal = parseCount(value, &options->shaping.flowSampleEvery);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-source-rate")) {
+            retVal = parseCount(value, &options->shaping.sourceFramesPerSecond);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-source-key")) {
+            if (optionIs(value, "bssid")) {
+                options->shaping.sourceKey = SHAPING_KEY_BSSID;
+            } else if (optionIs(value, "station")) {
+                options->shaping.sourceKey = SHAPING_KEY_STATION;
+            } else {
+                DEBUG("[ERROR] Unknown source key: %s", value);
+                return -1;
+            }
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-source-burst")) {
+            retVal = parseCount(value, &options->shaping.sourceBurst);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-max-fps")) {
+            retVal = parseCount(value, &options->shaping.framesPerSecond);
+        } else if (options->command == COMMAND_SNIFF && optionIs(arg, "-max-bps")) {
+            retVal = parseCount(value, &options->shaping.bytesPerSecond);
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-rate")) {
+            retVal = parseCount(value, &options->inject.rate);
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-count")) {
+            retVal = parseCount(value, &options->inject.count);
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-size")) {
+            retVal = parseCount(value, &options->inject.size);
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-template")) {
+            options->inject.templatePath = value;
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-loss")) {
+            retVal = parsePercent(value, &options->inject.simulateLoss);
+        } else if (options->command == COMMAND_INJECT && optionIs(arg, "-dup")) {
+            retVal = parsePercent(value, &options->inject.simulateDuplicates);
+        } else if (options->command == COMMAND_ANALYZE && optionIs(arg, "-threads")) {
+            retVal = parseCount(value, &options->threads);
+            if (retVal == 0 && (options->threads < 1 || options->threads > WORK_POOL_MAX_THREADS)) {
+                DEBUG("[ERROR] Threads must be 1-%u", WORK_POOL_MAX_THREADS);
+                return -1;
+            }
+        } else if ((options->command == COMMAND_SNIFF || options->command == COMMAND_SHM_DUMP)
+                && optionIs(arg, "-ring")) {
+            options->ringName = value;
+        } else if ((options->command == COMMAND_EXTRACT || options->command == COMMAND_ANALYZE)
+                && optionIs(arg, "-from")) {
+            retVal = parseSeconds(value, &options->fromUs);
+        } else if ((options->command == COMMAND_EXTRACT || options->command == COMMAND_ANALYZE)
+                && optionIs(arg, "-to")) {
+            retVal = parseSeconds(value, &options->toUs);
+        } else if ((options->command == COMMAND_EXTRACT || options->command == COMMAND_ANALYZE)
+                && optionIs(arg, "-addr")) {
+            if (ieee80211ParseAddress(value, options->address) < 0) {
+                DEBUG("[ERROR] Invalid address: %s", value);
+                return -1;
+            }
+            options->hasAddress = TRUE;
+        } else {
+            DEBUG("[ERROR] Unknown option %s", arg);
+            return -1;
+        }
+        ASSERT_ON_ERROR(retVal);
+        i++;
+    }
+    return 0;
+}
+
+void displayUsage() {
+    fprintf(stderr, "Usage:\n"
+            "  cc3100-wireshark-sniffer [-c channel] [-w capture.pcap]\n"
+            "          [-trigger deauth|assoc|aa:bb:cc:dd:ee:ff ...] [-pre sec] [-post sec]\n"
+            "      sniff into the WireShark pipe %s, or into a file with a sidecar index;\n"
+            "          [-sample n] [-flow-sample n] [-source-rate fps] [-source-burst n]"
+            " [-source-key bssid|station]"
+            " [-max-fps n] [-max-bps bytes]\n"
+            "          [-shm] [-ring name]\n"
+            "      with -trigger only the frames around a trigger are written,\n"
+            "      the shaping options keep a representative subset of a saturated channel,\n"
+            "      with -shm records go to the shared-memory ring %s for local readers\n"
+            "  cc3100-wireshark-sniffer extract <capture.pcap> <out.pcap> [-from sec] [-to sec]"
+            " [-addr aa:bb:cc:dd:ee:ff]\n"
+            "      copy the frames of a time range and/or address using the sidecar index\n"
+            "  cc3100-wireshark-sniffer shm-dump <out.pcap> [-ring name]\n"
+            "      save the records published to the shared-memory ring until the sniffer stops\n"
+            "  cc3100-wireshark-sniffer inject [-c channel] [-rate fps] [-count n] [-size bytes]"
+            " [-template capture.pcap]\n"
+            "          [-simulate] [-loss percent] [-dup percent]\n"
+            "      send numbered probe frames (default %u of %u bytes, rate 0 = unpaced), a sniffer\n"
+            "      reports their loss, duplication and delay; -simulate replaces the device by a\n"
+            "      stand-in that drops and duplicates the given share of the frames\n"
+            "  cc3100-wireshark-sniffer analyze <capture.pcap|capture.pcapng> [-threads n]"
+            " [-from sec] [-to sec] [-addr aa:bb:cc:dd:ee:ff]\n"
+            "      frame type mix, RSSI distribution and per-BSSID counters of a capture,\n"
+            "      computed on one thread per processor by default\n",
+            WIRESHARK_PIPE_NAME, SHM_RING_NAME, INJECT_DEFAULT_COUNT, INJECT_DEFAULT_SIZE);
+}
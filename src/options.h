@@ -0,0 +1,65 @@
+#ifndef __OPTIONS_H__
+#define __OPTIONS_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+#include "ieee80211.h"
+#include "trigger.h"
+#include "shaping.h"
+#include "shm_ring.h"
+#include "injector.h"
+#include "work_pool.h"
+
+#define DEFAULT_CHANNEL 10 /* 1-13 */
+#define WIRESHARK_PIPE_NAME "\\\\.\\pipe\\cc3100"
+
+typedef enum
+{
+    COMMAND_SNIFF, /* capture to the WireShark pipe or to a file */
+    COMMAND_EXTRACT, /* copy a time/address range of a capture file into a new one */
+    COMMAND_SHM_DUMP, /* save the records of the shared-memory ring into a capture file */
+    COMMAND_INJECT, /* generate probe traffic through the transceiver socket */
+    COMMAND_ANALYZE, /* statistics of a capture file */
+} e_Command;
+
+typedef struct options {
+    e_Command command;
+    _i16 channel;
+    const char *inputPath;
+    const char *outputPath; /* NULL sniffs into WIRESHARK_PIPE_NAME */
+    BOOL sharedMemory; /* sniff into the shared-memory ring instead */
+    const char *ringName;
+    triggerConfig_t trigger;
+    shapingConfig_t shaping;
+    injectConfig_t inject;
+
+    uint64_t fromUs;
+    uint64_t toUs;
+    BOOL hasAddress;
+    _u8 address[IEEE80211_ADDRESS_LENGTH];
+    _u32 threads; /* of the analyzer, 0 for one per processor */
+} options_t;
+
+/*!
+ \brief Parses the command line:
+
+   cc3100-wireshark-sniffer [-c channel] [-w capture.pcap]
+           [-trigger deauth|assoc|mac ...] [-pre sec] [-post sec]
+           [-sample n] [-flow-sample n] [-source-rate fps] [-source-burst n] [-source-key bssid|station]
+           [-max-fps n] [-max-bps n]
+           [-shm] [-ring name]
+   cc3100-wireshark-sniffer extract <capture.pcap> <out.pcap> [-from sec] [-to sec] [-addr mac]
+   cc3100-wireshark-sniffer shm-dump <out.pcap> [-ring name]
+   cc3100-wireshark-sniffer inject [-c channel] [-rate fps] [-count n] [-size bytes]
+           [-template capture.pcap] [-simulate] [-loss percent] [-dup percent]
+   cc3100-wireshark-sniffer analyze <capture.pcap|capture.pcapng> [-threads n] [-from sec] [-to sec]
+           [-addr mac]
+
+ \return 0 on success, negative on malformed command line
+ */
+_i32 parseOptions(int argc, char **argv, options_t *options);
+
+void displayUsage();
+
+#endif /* __OPTIONS_H__ */
@@ -0,0 +1,168 @@
+#include "main.h"
+
+static _i32 outputWriteAll(output_t *out, const void *data, _u32 length) {
+    DWORD byteWritten = 0;
+    BOOL result = WriteFile(out->handle, data, length, &byteWritten, NULL);
+
+    if (result == FALSE || byteWritten != length) {
+        DEBUG("[ERROR] Failed to write %u bytes", length);
+        return -1;
+    }
+    return 0;
+}
+
+static _i32 outputAllocateBatch(output_t *out) {
+    out->batch = arenaAlloc(ARENA_OUTPUT, OUTPUT_BATCH_BYTES);
+    if (out->batch == NULL) {
+        return -1;
+    }
+    out->batchUsed = 0;
+    out->batchFrames = 0;
+    out->maxBatchFrames = 0;
+    out->bytesWritten = 0;
+    out->index = NULL;
+    out->shm = NULL;
+    return 0;
+}
+
+_i32 outputOpenPipe(output_t *out, LPCSTR pipeName) {
+    if (outputAllocateBatch(out) < 0) {
+        return -1;
+    }
+    out->maxBatchFrames = OUTPUT_BATCH_FRAMES;
+
+    out->handle = CreateNamedPipe(pipeName, PIPE_ACCESS_OUTBOUND,
+    PIPE_TYPE_MESSAGE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES, 65536, 65536,
+    NMPWAIT_USE_DEFAULT_WAIT, NULL);
+
+    if (out->handle == INVALID_HANDLE_VALUE) {
+        DEBUG("[ERROR] Failed to create pipe");
+        return -1;
+    }
+
+    DEBUG("Waiting for connection from WireShark...");
+    DEBUG("pipe: %s", pipeName);
+
+    BOOL fConnected = ConnectNamedPipe(out->handle, NULL);
+
+    if (fConnected == 0) {
+        DEBUG("[ERROR] Failed to ConnectNamedPipe");
+        CloseHandle(out->handle);
+        out->handle = INVALID_HANDLE_VALUE;
+        return -1;
+    }
+    DEBUG("WireShark connected");
+    return 0;
+}
+
+_i32 outputOpenFile(output_t *out, const char *path, captureIndex_t *index) {
+    if (outputAllocateBatch(out) < 0) {
+        return -1;
+    }
+
+    out->handle = CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL, NULL);
+    if (out->handle == INVALID_HANDLE_VALUE) {
+        DEBUG("[ERROR] Failed to create %s", path);
+        return -1;
+    }
+
+    if (index != NULL && captureIndexOpen(index, path) < 0) {
+        return -1;
+    }
+    out->index = index;
+
+    DEBUG("Writing to %s", path);
+    return 0;
+}
+
+_i32 outputOpenSharedMemory(output_t *out, const char *name, shmProducer_t *shm) {
+    memset(out, 0, sizeof(*out));
+    out->handle = INVALID_HANDLE_VALUE;
+
+    if (shmProducerOpen(shm, name) < 0) {
+        return -1;
+    }
+    out->shm = shm;
+    return 0;
+}
+
+_i32 outputWriteGlobalHeader(output_t *out, const wireSharkGlobalHeader_t *gHeader) {
+    if (out->shm != NULL) {
+        shmProducerSetPcapHeader(out->shm, gHeader);
+        return 0;
+    }
+
+    _i32 retVal = outputWrite(out, gHeader, sizeof(*gHeader));
+    ASSERT_ON_ERROR(retVal);
+    return outputFlush(out);
+}
+
+_i32 outputWrite(output_t *out, const void *data, _u32 length) {
+    if (out->batchUsed + length > OUTPUT_BATCH_BYTES) {
+        _i32 retVal = outputFlush(out);
+        ASSERT_ON_ERROR(retVal);
+    }
+
+    out->bytesWritten += length;
+    if (length > OUTPUT_BATCH_BYTES) {
+        return outputWriteAll(out, data, length);
+    }
+
+    memcpy(&out->batch[out->batchUsed], data, length);
+    out->batchUsed += length;
+    return 0;
+}
+
+_i32 outputWriteRecord(output_t *out, const _u8 *record, _u32 length) {
+    if (out->shm != NULL) {
+        out->bytesWritten += length;
+        return shmProducerWrite(out->shm, record, length);
+    }
+
+    if (out->index != NULL) {
+        // An index entry is only published once the records it points to are on disk
+        if (captureIndexBlockFull(out->index, length)) {
+            _i32 retVal = outputFlush(out);
+            ASSERT_ON_ERROR(retVal);
+            retVal = captureIndexEmitBlock(out->index);
+            ASSERT_ON_ERROR(retVal);
+        }
+        captureIndexAdd(out->index, out->bytesWritten, record, length);
+    }
+
+    _i32 retVal = outputWrite(out, record, length);
+    ASSERT_ON_ERROR(retVal);
+
+    out->batchFrames++;
+    if (out->maxBatchFrames != 0 && out->batchFrames >= out->maxBatchFrames) {
+        return outputFlush(out);
+    }
+    return 0;
+}
+
+_i32 outputFlush(output_t *out) {
+    if (out->batchUsed > 0) {
+        _i32 retVal = outputWriteAll(out, out->batch, out->batchUsed);
+        ASSERT_ON_ERROR(retVal);
+    }
+    out->batchUsed = 0;
+    out->batchFrames = 0;
+    return 0;
+}
+
+_i32 outputClose(output_t *out) {
+    if (out->shm != NULL) {
+        shmProducerClose(out->shm);
+        out->shm = NULL;
+        return 0;
+    }
+
+    _i32 retVal = outputFlush(out);
+    if (out->index != NULL && captureIndexClose(out->index) < 0) {
+        retVal = -1;
+    }
+    CloseHandle(out->handle);
+    out->handle = INVALID_HANDLE_VALUE;
+    return retVal;
+}
@@ -0,0 +1,51 @@
+#ifndef __OUTPUT_H__
+#define __OUTPUT_H__
+
+#include "simplelink.h"
+#include "capture_index.h"
+#include "shm_producer.h"
+
+/*
+ * pcap records are collected in a batch buffer taken from the arena and written out with a single
+ * WriteFile call. For the pipe OUTPUT_BATCH_FRAMES = 1 keeps WireShark live, larger values trade
+ * latency for fewer system calls. Files are only written when the batch is full.
+ */
+#ifndef OUTPUT_BATCH_BYTES
+#define OUTPUT_BATCH_BYTES (16 * 1024)
+#endif
+
+#ifndef OUTPUT_BATCH_FRAMES
+#define OUTPUT_BATCH_FRAMES 1
+#endif
+
+typedef struct output {
+    HANDLE handle;
+    _u8 *batch;
+    _u32 batchUsed;
+    _u32 batchFrames;
+    _u32 maxBatchFrames; /* 0 flushes only when the batch is full */
+    uint64_t bytesWritten; /* bytes accepted so far, also the stream offset of the next record */
+    captureIndex_t *index; /* sidecar index of a capture file, NULL for the pipe */
+    shmProducer_t *shm; /* records go to the shared-memory ring instead of the batch */
+} output_t;
+
+_i32 outputOpenPipe(output_t *out, LPCSTR pipeName);
+
+// Creates the capture file together with its sidecar index
+_i32 outputOpenFile(output_t *out, const char *path, captureIndex_t *index);
+
+// Publishes records to local readers through the shared-memory ring \p name
+_i32 outputOpenSharedMemory(output_t *out, const char *name, shmProducer_t *shm);
+
+_i32 outputWriteGlobalHeader(output_t *out, const wireSharkGlobalHeader_t *gHeader);
+
+// Queues bytes to the batch, flushing it first when they do not fit
+_i32 outputWrite(output_t *out, const void *data, _u32 length);
+
+// Queues one complete pcap record and flushes once maxBatchFrames records are pending
+_i32 outputWriteRecord(output_t *out, const _u8 *record, _u32 length);
+
+_i32 outputFlush(output_t *out);
+_i32 outputClose(output_t *out);
+
+#endif /* __OUTPUT_H__ */
@@ -0,0 +1,107 @@
+#include "main.h"
+
+void pcapGlobalHeader(wireSharkGlobalHeader_t *gHeader) {
+    gHeader->magic_number = PCAP_MAGIC;
+    gHeader->version_major = 2;
+    gHeader->version_minor = 4;
+    gHeader->thiszone = 0;
+    gHeader->sigfigs = 0;
+    gHeader->snaplen = PCAP_SNAPLEN;
+    gHeader->network = LINKTYPE_IEEE802_11_RADIOTAP;
+}
+
+// 2.4 GHz band, channel 14 is the exception to the 5 MHz spacing
+static uint16_t pcapChannelFrequency(_u8 channel) {
+    return channel == 14 ? 2484 : 2407 + 5 * channel;
+}
+
+_u8 *pcapWrapFrame(_u8 *frame, _u32 frameLength, uint64_t timestampUs, _i8 rssi, _u8 channel,
+        _u32 *recordLength) {
+    pcapRadiotap_t radiotapHeader = {
+            .header = {
+                    .it_version = 0,
+                    .it_len = sizeof(pcapRadiotap_t),
+                    .it_present = (1 << RADIOTAP_CHANNEL) | (1 << RADIOTAP_DBM_ANTSIGNAL),
+            },
+            .channelFrequency = pcapChannelFrequency(channel),
+            .channelFlags = RADIOTAP_CHANNEL_2GHZ,
+            .antennaSignal = rssi,
+    };
+    pcapRecordHeader_t pcapHeader = {
+            .ts_sec = timestampUs / MICROSECONDS_IN_SECOND,
+            .ts_usec = timestampUs % MICROSECONDS_IN_SECOND,
+            .incl_len = frameLength + sizeof(pcapRadiotap_t),
+            .orig_len = frameLength + sizeof(pcapRadiotap_t),
+    };
+
+    _u8 *record = frame - PCAP_RECORD_HEADROOM;
+    memcpy(record, &pcapHeader, sizeof(pcapHeader));
+    memcpy(record + sizeof(pcapHeader), &radiotapHeader, sizeof(radiotapHeader));
+
+    *recordLength = PCAP_RECORD_HEADROOM + frameLength;
+    return record;
+}
+
+uint64_t pcapRecordTimestamp(const pcapRecordHeader_t *header) {
+    return (uint64_t) header->ts_sec * MICROSECONDS_IN_SECOND + header->ts_usec;
+}
+
+const _u8 *pcapRecordFrame(const _u8 *record, _u32 *frameLength) {
+    const pcapRecordHeader_t *header = (const pcapRecordHeader_t *) record;
+    const ieee80211RadiotapHeader_t *radiotapHeader =
+            (const ieee80211RadiotapHeader_t *) (record + sizeof(pcapRecordHeader_t));
+
+    if (header->incl_len < sizeof(ieee80211RadiotapHeader_t)
+            || radiotapHeader->it_len > header->incl_len) {
+        return NULL;
+    }
+
+    *frameLength = header->incl_len - radiotapHeader->it_len;
+    return record + sizeof(pcapRecordHeader_t) + radiotapHeader->it_len;
+}
+
+BOOL pcapRadiotapSignal(const _u8 *radiotap, _u32 length, _i8 *dbm) {
+    // Size and alignment of the fields in front of the antenna signal: TSFT, flags, rate, channel, FHSS
+    static const _u8 FIELD_SIZE[RADIOTAP_DBM_ANTSIGNAL] = { 8, 1, 1, 4, 2 };
+    static const _u8 FIELD_ALIGNMENT[RADIOTAP_DBM_ANTSIGNAL] = { 8, 1, 1, 2, 1 };
+
+    ieee80211RadiotapHeader_t header;
+    if (length < sizeof(header)) {
+        return FALSE;
+    }
+    memcpy(&header, radiotap, sizeof(header));
+    if (header.it_len > length || !(header.it_present & (1 << RADIOTAP_DBM_ANTSIGNAL))) {
+        return FALSE;
+    }
+
+    // Fields start after the last it_present word
+    _u32 offset = sizeof(header);
+    uint32_t present = header.it_present;
+    while (present & (1U << RADIOTAP_EXT)) {
+        if (offset + sizeof(present) > header.it_len) {
+            return FALSE;
+        }
+        memcpy(&present, &radiotap[offset], sizeof(present));
+        offset += sizeof(present);
+    }
+
+    for (_u32 field = 0; field < RADIOTAP_DBM_ANTSIGNAL; field++) {
+        if (header.it_present & (1 << field)) {
+            offset = (offset + FIELD_ALIGNMENT[field] - 1) & ~(FIELD_ALIGNMENT[field] - 1);
+            offset += FIELD_SIZE[field];
+        }
+    }
+    if (offset >= header.it_len) {
+        return FALSE;
+    }
+    *dbm = (_i8) radiotap[offset];
+    return TRUE;
+}
+
+uint64_t pcapClockExtend(pcapClock_t *clock, _u32 deviceTimestampUs) {
+    if (deviceTimestampUs < clock->lastUs) {
+        clock->epochUs += 1ULL << 32;
+    }
+    clock->lastUs = deviceTimestampUs;
+    return clock->epochUs + deviceTimestampUs;
+}
@@ -0,0 +1,90 @@
+#ifndef __PCAP_H__
+#define __PCAP_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+
+#define PCAP_MAGIC 0xA1B2C3D4
+#define PCAP_SNAPLEN 0x0000FFFF
+#define PCAP_MAGIC_NANOSECONDS 0xA1B23C4D
+#define LINKTYPE_IEEE802_11 105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+
+#define MICROSECONDS_IN_SECOND 1000000
+
+// Largest transfer on the transceiver socket: SlTransceiverRxOverHead_t followed by the 802.11 frame
+#define CAPTURE_MTU 1536
+
+// https://wiki.wireshark.org/Development/LibpcapFileFormat
+typedef struct wireSharkGlobalHeader {
+    uint32_t magic_number; /* magic number */
+    uint16_t version_major; /* major version number */
+    uint16_t version_minor; /* minor version number */
+    int32_t thiszone; /* GMT to local correction */
+    uint32_t sigfigs; /* accuracy of timestamps */
+    uint32_t snaplen; /* max length of captured packets, in octets */
+    uint32_t network; /* data link type */
+} wireSharkGlobalHeader_t;
+
+typedef struct pcapRecordHeader {
+    uint32_t ts_sec; /* timestamp seconds */
+    uint32_t ts_usec; /* timestamp microseconds */
+    uint32_t incl_len; /* number of octets of packet saved in file */
+    uint32_t orig_len; /* actual length of packet */
+} pcapRecordHeader_t;
+
+// http://www.radiotap.org/
+typedef struct ieee80211RadiotapHeader {
+    uint8_t it_version; /* set to 0 */
+    uint8_t it_pad;
+    uint16_t it_len; /* entire length */
+    uint32_t it_present; /* fields present */
+} ieee80211RadiotapHeader_t;
+
+#define RADIOTAP_CHANNEL 3 /* u16 frequency in MHz, u16 flags, 2 octet aligned */
+#define RADIOTAP_DBM_ANTSIGNAL 5 /* s8 dBm */
+#define RADIOTAP_EXT 31 /* another it_present word follows */
+#define RADIOTAP_CHANNEL_2GHZ 0x0080
+
+// Radiotap header written by the sniffer: the channel and the RSSI reported by the device
+typedef struct __attribute__((packed)) pcapRadiotap {
+    ieee80211RadiotapHeader_t header;
+    uint16_t channelFrequency;
+    uint16_t channelFlags;
+    int8_t antennaSignal;
+} pcapRadiotap_t;
+
+// Room the receive buffer keeps in front of the frame so that a pcap record can be built in place
+#define PCAP_RECORD_HEADROOM (sizeof(pcapRecordHeader_t) + sizeof(pcapRadiotap_t))
+
+void pcapGlobalHeader(wireSharkGlobalHeader_t *gHeader);
+
+/*!
+ \brief Wraps a frame received from the transceiver socket into a pcap record.
+
+ The pcap record header and the radiotap header are written into the PCAP_RECORD_HEADROOM bytes
+ that precede \p frame, so the resulting record is one contiguous span and the frame is not copied.
+
+ \return pointer to the first byte of the record, its length is stored in \p recordLength
+ */
+_u8 *pcapWrapFrame(_u8 *frame, _u32 frameLength, uint64_t timestampUs, _i8 rssi, _u8 channel,
+        _u32 *recordLength);
+
+uint64_t pcapRecordTimestamp(const pcapRecordHeader_t *header);
+
+// Skips the radiotap header of a record, returns NULL when the record is malformed
+const _u8 *pcapRecordFrame(const _u8 *record, _u32 *frameLength);
+
+// Finds the dBm antenna signal in a radiotap header of any writer, FALSE when it is not present
+BOOL pcapRadiotapSignal(const _u8 *radiotap, _u32 length, _i8 *dbm);
+
+// Extends the 32 bit microsecond radio clock, which wraps every ~71 minutes, to 64 bits
+typedef struct pcapClock {
+    uint64_t epochUs;
+    _u32 lastUs;
+} pcapClock_t;
+
+uint64_t pcapClockExtend(pcapClock_t *clock, _u32 deviceTimestampUs);
+
+#endif /* __PCAP_H__ */
@@ -0,0 +1,97 @@
+#include "main.h"
+
+#define SEEN_BIT(sequence) ((sequence) & (PROBE_WINDOW - 1))
+
+static BOOL probeSeen(const probeStats_t *stats, uint32_t sequence) {
+    _u32 bit = SEEN_BIT(sequence);
+    return (stats->seen[bit / 32] & (1u << (bit % 32))) != 0;
+}
+
+static void probeMark(probeStats_t *stats, uint32_t sequence, BOOL seen) {
+    _u32 bit = SEEN_BIT(sequence);
+    if (seen) {
+        stats->seen[bit / 32] |= 1u << (bit % 32);
+    } else {
+        stats->seen[bit / 32] &= ~(1u << (bit % 32));
+    }
+}
+
+static void probeStart(probeStats_t *stats, const probe_t *probe) {
+    memset(stats, 0, sizeof(*stats));
+    stats->started = TRUE;
+    stats->run = probe->run;
+    stats->firstSequence = probe->sequence;
+    stats->highestSequence = probe->sequence;
+    stats->received = 1;
+    probeMark(stats, probe->sequence, TRUE);
+}
+
+void probeStamp(_u8 *body, uint32_t run, uint32_t sequence, latencyTick_t sent) {
+    probe_t probe = {
+            .magic = PROBE_MAGIC,
+            .run = run,
+            .sequence = sequence,
+            .sentUs = latencyTicksToMicroseconds(sent),
+    };
+    memcpy(body, &probe, sizeof(probe));
+}
+
+BOOL probeObserve(probeStats_t *stats, const _u8 *record, latencyTick_t arrival) {
+    _u32 frameLength = 0;
+    const _u8 *frame = pcapRecordFrame(record, &frameLength);
+    ieee80211Frame_t parsed;
+    if (frame == NULL || ieee80211Parse(frame, frameLength, &parsed) < 0
+            || parsed.type != IEEE80211_TYPE_DATA || parsed.bodyLength < sizeof(probe_t)) {
+        return FALSE;
+    }
+
+    probe_t probe;
+    memcpy(&probe, parsed.body, sizeof(probe));
+    if (probe.magic != PROBE_MAGIC) {
+        return FALSE;
+    }
+
+    latencyRecord(LATENCY_PROBE, latencyMicrosecondsToTicks(probe.sentUs), arrival);
+
+    if (!stats->started || probe.run != stats->run) {
+        probeStart(stats, &probe);
+        return TRUE;
+    }
+
+    int32_t ahead = (int32_t) (probe.sequence - stats->highestSequence);
+    if (ahead > 0) {
+        // Forget the sequences that slide out of the window
+        for (int32_t i = 1; i <= ahead && i <= PROBE_WINDOW; i++) {
+            probeMark(stats, stats->highestSequence + i, FALSE);
+        }
+        stats->highestSequence = probe.sequence;
+        probeMark(stats, probe.sequence, TRUE);
+        stats->received++;
+    } else if (-ahead >= PROBE_WINDOW) {
+        stats->tooOld++;
+    } else if (probeSeen(stats, probe.sequence)) {
+        stats->duplicates++;
+    } else {
+        probeMark(stats, probe.sequence, TRUE);
+        stats->received++;
+        stats->reordered++;
+    }
+    return TRUE;
+}
+
+void probeReport(const probeStats_t *stats) {
+    if (!stats->started) {
+        return;
+    }
+
+    uint64_t expected = (uint64_t) (stats->highestSequence - stats->firstSequence) + 1;
+    uint64_t arrived = stats->received + stats->tooOld; // late frames arrived, they are not lost
+    uint64_t lost = expected > arrived ? expected - arrived : 0;
+
+    REPORT("Probes of run %08x: sequences %u-%u", stats->run, stats->firstSequence,
+            stats->highestSequence);
+    REPORT("  received %llu, lost %llu (%.3f%%), duplicated %llu, reordered %llu, too late %llu",
+            (unsigned long long) stats->received, (unsigned long long) lost,
+            100.0 * lost / expected, (unsigned long long) stats->duplicates,
+            (unsigned long long) stats->reordered, (unsigned long long) stats->tooOld);
+}
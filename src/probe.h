@@ -0,0 +1,46 @@
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+#include "latency.h"
+
+/*
+ * Probes are embedded at the start of the body of every injected frame. A capture recognizes them
+ * and counts received, lost, duplicated and reordered frames per injection run, and the delay from
+ * sl_Send to arrival. The delay is only meaningful when the generator runs on the same host as the
+ * sniffer, both sides stamp with QueryPerformanceCounter.
+ */
+#define PROBE_MAGIC 0x42503343 /* "C3PB" */
+#define PROBE_WINDOW 1024 /* sequences remembered for duplicate detection, power of two */
+
+typedef struct probe {
+    uint32_t magic;
+    uint32_t run; /* changes with every generator start */
+    uint32_t sequence;
+    uint32_t reserved;
+    uint64_t sentUs; /* QueryPerformanceCounter of the sender, in microseconds */
+} probe_t;
+
+typedef struct probeStats {
+    BOOL started;
+    uint32_t run;
+    uint32_t firstSequence;
+    uint32_t highestSequence;
+    uint64_t received; /* distinct sequences */
+    uint64_t duplicates;
+    uint64_t reordered;
+    uint64_t tooOld; /* arrived more than PROBE_WINDOW sequences late */
+    uint32_t seen[PROBE_WINDOW / 32]; /* bitmap of the last PROBE_WINDOW sequences */
+} probeStats_t;
+
+// Stamps a probe into \p body, which has to hold sizeof(probe_t) octets
+void probeStamp(_u8 *body, uint32_t run, uint32_t sequence, latencyTick_t sent);
+
+// Accounts the record when it carries a probe, returns FALSE otherwise
+BOOL probeObserve(probeStats_t *stats, const _u8 *record, latencyTick_t arrival);
+
+void probeReport(const probeStats_t *stats);
+
+#endif /* __PROBE_H__ */
@@ -0,0 +1,181 @@
+#include "main.h"
+
+#define TOKEN 1000000ULL /* one token in millionths, refill is rate * elapsed microseconds */
+#define MAX_REFILL_US (60ULL * MICROSECONDS_IN_SECOND)
+
+static const char * const VERDICT_NAMES[SHAPING_VERDICT_COUNT] = {
+        [SHAPING_KEPT] = "kept",
+        [SHAPING_SAMPLED] = "sampled",
+        [SHAPING_FLOW_SAMPLED] = "flow-sampled",
+        [SHAPING_SOURCE_LIMITED] = "source-limited",
+        [SHAPING_FRAMES_LIMITED] = "frames-limited",
+        [SHAPING_BYTES_LIMITED] = "bytes-limited",
+};
+
+static void tokenBucketStart(tokenBucket_t *bucket, uint64_t burst, uint64_t nowUs) {
+    bucket->tokens = burst * TOKEN;
+    bucket->lastUs = nowUs;
+}
+
+// Takes \p cost tokens if the bucket holds them, refilling \p rate tokens per second up to \p burst
+static BOOL tokenBucketTake(tokenBucket_t *bucket, uint64_t rate, uint64_t burst, uint64_t cost,
+        uint64_t nowUs) {
+    if (nowUs > bucket->lastUs) {
+        uint64_t elapsedUs = nowUs - bucket->lastUs;
+        if (elapsedUs > MAX_REFILL_US) {
+            elapsedUs = MAX_REFILL_US;
+        }
+        bucket->tokens += elapsedUs * rate;
+        if (bucket->tokens > burst * TOKEN) {
+            bucket->tokens = burst * TOKEN;
+        }
+    }
+    bucket->lastUs = nowUs;
+
+    if (bucket->tokens < cost * TOKEN) {
+        return FALSE;
+    }
+    bucket->tokens -= cost * TOKEN;
+    return TRUE;
+}
+
+static BOOL shapingFlowKept(const shaping_t *shaping, const ieee80211Frame_t *parsed) {
+    // Both directions of a conversation hash the same
+    const _u8 *low = parsed->addr1;
+    const _u8 *high = parsed->addr2;
+    if (high != NULL && memcmp(low, high, IEEE80211_ADDRESS_LENGTH) > 0) {
+        low = parsed->addr2;
+        high = parsed->addr1;
+    }
+
+    uint64_t hash = ieee80211AddressHash(low, IEEE80211_HASH_SEED);
+    if (high != NULL) {
+        hash = ieee80211AddressHash(high, hash);
+    }
+    return (hash >> 32) % shaping->config.flowSampleEvery == 0;
+}
+
+// Finds the bucket of \p address, recycling the least recently used slot of the probe window
+static shapingSource_t *shapingSource(shaping_t *shaping, const _u8 *address, uint64_t nowUs) {
+    _u32 slot = (_u32) ieee80211AddressHash(address, IEEE80211_HASH_SEED) & (SHAPING_SOURCES - 1);
+    shapingSource_t *oldest = NULL;
+
+    for (_u32 probe = 0; probe < SHAPING_PROBE_LENGTH; probe++) {
+        shapingSource_t *source = &shaping->sources[(slot + probe) & (SHAPING_SOURCES - 1)];
+        if (source->used && ieee80211AddressIs(source->address, address)) {
+            return source;
+        }
+        if (oldest == NULL || !source->used
+                || (oldest->used && source->bucket.lastUs < oldest->bucket.lastUs)) {
+            oldest = source;
+        }
+    }
+
+    memcpy(oldest->address, address, IEEE80211_ADDRESS_LENGTH);
+    oldest->used = TRUE;
+    tokenBucketStart(&oldest->bucket, shaping->config.sourceBurst, nowUs);
+    return oldest;
+}
+
+static e_ShapingVerdict shapingDecide(shaping_t *shaping, const _u8 *record, _u32 length) {
+    const shapingConfig_t *config = &shaping->config;
+
+    if (config->sampleEvery > 1) {
+        if (shaping->sampleCountdown > 0) {
+            shaping->sampleCountdown--;
+            return SHAPING_SAMPLED;
+        }
+        shaping->sampleCountdown = config->sampleEvery - 1;
+    }
+
+    uint64_t nowUs = pcapRecordTimestamp((const pcapRecordHeader_t *) record);
+    _u32 frameLength = 0;
+    const _u8 *frame = pcapRecordFrame(record, &frameLength);
+    ieee80211Frame_t parsed;
+    BOOL hasHeader = frame != NULL && ieee80211Parse(frame, frameLength, &parsed) == 0;
+
+    if (config->flowSampleEvery > 1 && hasHeader && !shapingFlowKept(shaping, &parsed)) {
+        return SHAPING_FLOW_SAMPLED;
+    }
+
+    if (config->sourceFramesPerSecond != 0 && hasHeader) {
+        const _u8 *address = config->sourceKey == SHAPING_KEY_STATION || parsed.bssid == NULL ?
+                parsed.addr2 : parsed.bssid;
+        if (address != NULL) {
+            shapingSource_t *source = shapingSource(shaping, address, nowUs);
+            if (!tokenBucketTake(&source->bucket, config->sourceFramesPerSecond,
+                    config->sourceBurst, 1, nowUs)) {
+                return SHAPING_SOURCE_LIMITED;
+            }
+        }
+    }
+
+    if (config->framesPerSecond != 0
+            && !tokenBucketTake(&shaping->frames, config->framesPerSecond, config->framesPerSecond,
+                    1, nowUs)) {
+        return SHAPING_FRAMES_LIMITED;
+    }
+
+    if (config->bytesPerSecond != 0
+            && !tokenBucketTake(&shaping->bytes, config->bytesPerSecond, shaping->bytesBurst,
+                    length, nowUs)) {
+        return SHAPING_BYTES_LIMITED;
+    }
+    return SHAPING_KEPT;
+}
+
+BOOL shapingEnabled(const shapingConfig_t *config) {
+    return config->sampleEvery > 1 || config->flowSampleEvery > 1
+            || config->sourceFramesPerSecond != 0 || config->framesPerSecond != 0
+            || config->bytesPerSecond != 0;
+}
+
+_i32 shapingInit(shaping_t *shaping, const shapingConfig_t *config) {
+    memset(shaping, 0, sizeof(*shaping));
+    shaping->config = *config;
+    if (shaping->config.sourceBurst == 0) {
+        shaping->config.sourceBurst = shaping->config.sourceFramesPerSecond;
+    }
+    shaping->bytesBurst = config->bytesPerSecond;
+    if (config->bytesPerSecond != 0 && config->bytesPerSecond < SHAPING_MAX_RECORD) {
+        REPORT("-max-bps %u is below one record of up to %u bytes, records pass one at a time",
+                config->bytesPerSecond, (unsigned) SHAPING_MAX_RECORD);
+        shaping->bytesBurst = SHAPING_MAX_RECORD;
+    }
+
+    if (config->sourceFramesPerSecond != 0) {
+        shaping->sources = arenaAlloc(ARENA_SHAPING, SHAPING_SOURCES * sizeof(shapingSource_t));
+        if (shaping->sources == NULL) {
+            return -1;
+        }
+    }
+
+    // Global buckets start full, the first timestamp seen becomes their reference
+    tokenBucketStart(&shaping->frames, config->framesPerSecond, 0);
+    tokenBucketStart(&shaping->bytes, shaping->bytesBurst, 0);
+    return 0;
+}
+
+e_ShapingVerdict shapingAccept(shaping_t *shaping, const _u8 *record, _u32 length) {
+    e_ShapingVerdict verdict = shapingDecide(shaping, record, length);
+    shaping->records[verdict]++;
+    shaping->octets[verdict] += length;
+    return verdict;
+}
+
+void shapingReport(const shaping_t *shaping) {
+    uint64_t offered = 0;
+    for (int verdict = 0; verdict < SHAPING_VERDICT_COUNT; verdict++) {
+        offered += shaping->records[verdict];
+    }
+
+    REPORT("Shaping: %llu records offered", (unsigned long long) offered);
+    for (int verdict = 0; verdict < SHAPING_VERDICT_COUNT; verdict++) {
+        REPORT("  %-15s %12llu records %14llu bytes", VERDICT_NAMES[verdict],
+                (unsigned long long) shaping->records[verdict],
+                (unsigned long long) shaping->octets[verdict]);
+    }
+    if (shaping->records[SHAPING_KEPT] != 0) {
+        REPORT("  scale factor    %.3f", (double) offered / shaping->records[SHAPING_KEPT]);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __SHAPING_H__
+#define __SHAPING_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+#include "ieee80211.h"
+
+/*
+ * Output shaping keeps a representative subset of a saturated channel instead of losing frames at
+ * random in the device. A frame passes, in this order:
+ *   - deterministic 1-in-N sampling
+ *   - flow sampling: the unordered address pair of the frame is hashed, 1 in N flows is kept
+ *   - a token bucket per source: per BSSID (transmitter when the frame has none), or per station
+ *     (transmitter) so that a single chatty station can be limited on its own
+ *   - global frames/s and bytes/s token buckets
+ * Rates are measured on the radio clock. Every stage counts what it dropped so the statistics of
+ * a shaped capture can be scaled back up.
+ */
+#ifndef SHAPING_SOURCES
+#define SHAPING_SOURCES 256 /* per-source token buckets, power of two */
+#endif
+
+#define SHAPING_PROBE_LENGTH 4
+// Smallest burst of the bytes/s cap, one record of the largest transfer
+#define SHAPING_MAX_RECORD (PCAP_RECORD_HEADROOM + CAPTURE_MTU)
+
+typedef enum
+{
+    SHAPING_KEY_BSSID, /* one bucket per BSSID */
+    SHAPING_KEY_STATION, /* one bucket per transmitter, frames without one are not limited */
+} e_ShapingSourceKey;
+
+typedef struct shapingConfig {
+    _u32 sampleEvery; /* 0 or 1 keeps every frame */
+    _u32 flowSampleEvery; /* 0 or 1 keeps every flow */
+    _u32 sourceFramesPerSecond; /* 0 disables the per-source buckets */
+    _u32 sourceBurst; /* frames, 0 allows one second worth */
+    e_ShapingSourceKey sourceKey;
+    _u32 framesPerSecond; /* global cap, 0 disables */
+    _u32 bytesPerSecond; /* global cap, 0 disables */
+} shapingConfig_t;
+
+typedef struct tokenBucket {
+    uint64_t tokens; /* in millionths of a token */
+    uint64_t lastUs;
+} tokenBucket_t;
+
+typedef struct shapingSource {
+    _u8 address[IEEE80211_ADDRESS_LENGTH];
+    BOOL used;
+    tokenBucket_t bucket;
+} shapingSource_t;
+
+typedef enum
+{
+    SHAPING_KEPT,
+    SHAPING_SAMPLED, /* dropped by 1-in-N sampling */
+    SHAPING_FLOW_SAMPLED, /* dropped by flow sampling */
+    SHAPING_SOURCE_LIMITED, /* dropped by the per-source bucket */
+    SHAPING_FRAMES_LIMITED, /* dropped by the global frames/s cap */
+    SHAPING_BYTES_LIMITED, /* dropped by the global bytes/s cap */
+
+    SHAPING_VERDICT_COUNT
+} e_ShapingVerdict;
+
+typedef struct shaping {
+    shapingConfig_t config;
+    shapingSource_t *sources;
+    tokenBucket_t frames;
+    tokenBucket_t bytes;
+    _u32 bytesBurst; /* at least one record, or a record longer than the cap never passes */
+    _u32 sampleCountdown;
+
+    uint64_t records[SHAPING_VERDICT_COUNT];
+    uint64_t octets[SHAPING_VERDICT_COUNT];
+} shaping_t;
+
+BOOL shapingEnabled(const shapingConfig_t *config);
+
+_i32 shapingInit(shaping_t *shaping, const shapingConfig_t *config);
+
+e_ShapingVerdict shapingAccept(shaping_t *shaping, const _u8 *record, _u32 length);
+
+// Prints every counter and the factor that scales kept frames back to the offered load
+void shapingReport(const shaping_t *shaping);
+
+#endif /* __SHAPING_H__ */
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "shm_consumer.h"
+
+static uint64_t shmLoad(const uint64_t *position) {
+    return __atomic_load_n(position, __ATOMIC_ACQUIRE);
+}
+
+// The bytes at \p position are intact as long as the producer has not reserved past them by a lap
+static BOOL shmConsumerIntact(const shmConsumer_t *consumer, uint64_t position) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t reserved = __atomic_load_n(&consumer->ring->reservePosition, __ATOMIC_RELAXED);
+    return reserved - position <= consumer->ring->capacity;
+}
+
+static void shmConsumerResync(shmConsumer_t *consumer) {
+    consumer->readPosition = shmLoad(&consumer->ring->oldestPosition);
+    consumer->laps++;
+}
+
+int shmConsumerOpen(shmConsumer_t *consumer, const char *name) {
+    memset(consumer, 0, sizeof(*consumer));
+
+    consumer->mapping = OpenFileMapping(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+    if (consumer->mapping == NULL) {
+        return -1;
+    }
+
+    consumer->ring = (shmRingHeader_t *) MapViewOfFile(consumer->mapping,
+    FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    if (consumer->ring == NULL || consumer->ring->magic != SHM_RING_MAGIC
+            || consumer->ring->version != SHM_RING_VERSION) {
+        shmConsumerClose(consumer);
+        return -1;
+    }
+    consumer->data = (const uint8_t *) consumer->ring + consumer->ring->dataOffset;
+
+    char eventName[MAX_PATH];
+    snprintf(eventName, sizeof(eventName), "%s" SHM_RING_EVENT_SUFFIX, name);
+    consumer->event = OpenEvent(SYNCHRONIZE, FALSE, eventName);
+
+    consumer->readPosition = shmLoad(&consumer->ring->writePosition);
+    return 0;
+}
+
+const uint8_t *shmConsumerPcapHeader(const shmConsumer_t *consumer) {
+    return consumer->ring->pcapHeader;
+}
+
+int shmConsumerPeek(shmConsumer_t *consumer, const uint8_t **record, uint32_t *length) {
+    const uint64_t mask = consumer->ring->capacity - 1;
+
+    while (TRUE) {
+        uint64_t position = consumer->readPosition;
+        if (position == shmLoad(&consumer->ring->writePosition)) {
+            return 0;
+        }
+
+        const shmRingSlot_t *slot = (const shmRingSlot_t *) &consumer->data[position & mask];
+        shmRingSlot_t header = *slot;
+        if (!shmConsumerIntact(consumer, position)) {
+            shmConsumerResync(consumer);
+            continue;
+        }
+
+        if (header.length == SHM_RING_PAD) {
+            consumer->readPosition = position + consumer->ring->capacity - (position & mask);
+            continue;
+        }
+
+        if (consumer->sequenceKnown && header.sequence != consumer->nextSequence) {
+            consumer->lost += (uint32_t) (header.sequence - consumer->nextSequence);
+        }
+        consumer->sequenceKnown = TRUE;
+        consumer->nextSequence = header.sequence + 1;
+
+        consumer->peekedSpan = SHM_RING_SLOT_SPAN(header.length);
+        *record = (const uint8_t *) (slot + 1);
+        *length = header.length;
+        return 1;
+    }
+}
+
+BOOL shmConsumerRelease(shmConsumer_t *consumer) {
+    if (consumer->peekedSpan == 0) {
+        return FALSE;
+    }
+
+    BOOL intact = shmConsumerIntact(consumer, consumer->readPosition);
+    consumer->readPosition += consumer->peekedSpan;
+    consumer->peekedSpan = 0;
+
+    if (intact) {
+        consumer->records++;
+    } else {
+        consumer->lost++;
+        shmConsumerResync(consumer);
+    }
+    return intact;
+}
+
+void shmConsumerWait(shmConsumer_t *consumer, DWORD timeoutMs) {
+    if (consumer->event == NULL) {
+        Sleep(1);
+        return;
+    }
+
+    // Announce the wait before the last look at writePosition, the producer checks the flag after
+    // publishing, so one of the two sees the other
+    __atomic_store_n(&consumer->ring->readerWaiting, 1, __ATOMIC_SEQ_CST);
+    if (consumer->readPosition != __atomic_load_n(&consumer->ring->writePosition, __ATOMIC_SEQ_CST)
+            || __atomic_load_n(&consumer->ring->producerClosed, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    WaitForSingleObject(consumer->event, timeoutMs);
+}
+
+BOOL shmConsumerFinished(shmConsumer_t *consumer) {
+    return __atomic_load_n(&consumer->ring->producerClosed, __ATOMIC_ACQUIRE)
+            && consumer->readPosition == shmLoad(&consumer->ring->writePosition);
+}
+
+void shmConsumerClose(shmConsumer_t *consumer) {
+    if (consumer->ring != NULL) {
+        UnmapViewOfFile(consumer->ring);
+    }
+    if (consumer->mapping != NULL) {
+        CloseHandle(consumer->mapping);
+    }
+    if (consumer->event != NULL) {
+        CloseHandle(consumer->event);
+    }
+    memset(consumer, 0, sizeof(*consumer));
+}
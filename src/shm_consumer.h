@@ -0,0 +1,67 @@
+#ifndef __SHM_CONSUMER_H__
+#define __SHM_CONSUMER_H__
+
+#include <stdint.h>
+#include <windows.h>
+
+#include "shm_ring.h"
+
+/*
+ * Reads pcap records in place from the ring published by "cc3100-wireshark-sniffer -shm".
+ *
+ *   shmConsumerOpen(&consumer, SHM_RING_NAME);
+ *   while (...) {
+ *       int retVal = shmConsumerPeek(&consumer, &record, &length);
+ *       if (retVal == 0) {
+ *           shmConsumerWait(&consumer, 100);
+ *       } else if (retVal > 0) {
+ *           ...use record...
+ *           if (!shmConsumerRelease(&consumer)) {
+ *               ...the producer overwrote the record meanwhile, discard what was derived from it...
+ *           }
+ *       }
+ *   }
+ *
+ * Reading does not make system calls, only shmConsumerWait() blocks on the event when the ring is
+ * drained. The event wakes one waiting reader, other readers return on their timeout.
+ */
+typedef struct shmConsumer {
+    HANDLE mapping;
+    HANDLE event;
+    shmRingHeader_t *ring;
+    const uint8_t *data;
+    uint64_t readPosition;
+    uint64_t peekedSpan; /* of the slot returned by the last shmConsumerPeek, 0 when none */
+
+    BOOL sequenceKnown;
+    uint32_t nextSequence;
+    uint64_t records; /* released intact */
+    uint64_t lost; /* overwritten before they were read */
+    uint64_t laps; /* times the reader was lapped and resynchronized */
+} shmConsumer_t;
+
+// Attaches to the ring \p name, reading starts with the next record published
+int shmConsumerOpen(shmConsumer_t *consumer, const char *name);
+
+// The 24 byte pcap global header describing the records
+const uint8_t *shmConsumerPcapHeader(const shmConsumer_t *consumer);
+
+/*!
+ \brief Points \p record at the next pcap record, in place in the ring
+
+ \return 1 when a record is returned, 0 when the ring is drained
+ */
+int shmConsumerPeek(shmConsumer_t *consumer, const uint8_t **record, uint32_t *length);
+
+// Moves past the peeked record, FALSE when it was overwritten while being used
+BOOL shmConsumerRelease(shmConsumer_t *consumer);
+
+// Blocks until the producer publishes a record or \p timeoutMs elapses
+void shmConsumerWait(shmConsumer_t *consumer, DWORD timeoutMs);
+
+// TRUE once the producer is gone and every record was read
+BOOL shmConsumerFinished(shmConsumer_t *consumer);
+
+void shmConsumerClose(shmConsumer_t *consumer);
+
+#endif /* __SHM_CONSUMER_H__ */
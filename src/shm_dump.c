@@ -0,0 +1,55 @@
+#include "main.h"
+
+#define WAIT_TIMEOUT_MS 100
+
+// A record is copied out before it is released, the copy is only written when it was intact
+static _u8 g_record[sizeof(pcapRecordHeader_t) + PCAP_SNAPLEN];
+
+_i32 dumpSharedMemory(const options_t *options) {
+    shmConsumer_t consumer;
+    if (shmConsumerOpen(&consumer, options->ringName) < 0) {
+        DEBUG("[ERROR] No shared memory ring %s, is the sniffer running with -shm?",
+                options->ringName);
+        return -1;
+    }
+
+    output_t out;
+    captureIndex_t index;
+    if (outputOpenFile(&out, options->outputPath, &index) < 0
+            || outputWriteGlobalHeader(&out,
+                    (const wireSharkGlobalHeader_t *) shmConsumerPcapHeader(&consumer)) < 0) {
+        shmConsumerClose(&consumer);
+        return -1;
+    }
+
+    installCtrlHandler();
+
+    _i32 retVal = 0;
+    while (retVal == 0 && !isStopRequested() && !shmConsumerFinished(&consumer)) {
+        const uint8_t *record = NULL;
+        uint32_t length = 0;
+
+        if (shmConsumerPeek(&consumer, &record, &length) == 0) {
+            shmConsumerWait(&consumer, WAIT_TIMEOUT_MS);
+            continue;
+        }
+
+        BOOL fits = length <= sizeof(g_record);
+        if (fits) {
+            memcpy(g_record, record, length);
+        }
+        if (shmConsumerRelease(&consumer) && fits) {
+            retVal = outputWriteRecord(&out, g_record, length);
+        }
+    }
+
+    if (outputClose(&out) < 0) {
+        retVal = -1;
+    }
+
+    REPORT("Shared memory: %llu records saved, %llu lost, lapped %llu time(s)",
+            (unsigned long long) consumer.records, (unsigned long long) consumer.lost,
+            (unsigned long long) consumer.laps);
+    shmConsumerClose(&consumer);
+    return retVal;
+}
@@ -0,0 +1,15 @@
+#ifndef __SHM_DUMP_H__
+#define __SHM_DUMP_H__
+
+#include "simplelink.h"
+#include "options.h"
+
+/*!
+ \brief Saves the records published to the shared-memory ring options->ringName into
+ options->outputPath, until the sniffer closes the ring or Ctrl+C is pressed.
+
+ \return 0 on success, negative on error
+ */
+_i32 dumpSharedMemory(const options_t *options);
+
+#endif /* __SHM_DUMP_H__ */
@@ -0,0 +1,122 @@
+#include "main.h"
+
+_i32 shmProducerOpen(shmProducer_t *producer, const char *name) {
+    memset(producer, 0, sizeof(*producer));
+
+    if ((SHM_RING_BYTES & (SHM_RING_BYTES - 1)) != 0) {
+        DEBUG("[ERROR] SHM_RING_BYTES must be a power of two");
+        return -1;
+    }
+
+    producer->mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+    SHM_RING_DATA_OFFSET + SHM_RING_BYTES, name);
+    if (producer->mapping == NULL) {
+        DEBUG("[ERROR] Failed to create shared memory %s", name);
+        return -1;
+    }
+
+    producer->ring = MapViewOfFile(producer->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (producer->ring == NULL) {
+        DEBUG("[ERROR] Failed to map shared memory %s", name);
+        return -1;
+    }
+    producer->data = (_u8 *) producer->ring + SHM_RING_DATA_OFFSET;
+
+    char eventName[MAX_PATH];
+    snprintf(eventName, sizeof(eventName), "%s" SHM_RING_EVENT_SUFFIX, name);
+    producer->event = CreateEvent(NULL, FALSE, FALSE, eventName);
+    if (producer->event == NULL) {
+        DEBUG("[ERROR] Failed to create event %s", eventName);
+        return -1;
+    }
+
+    // A previous run may have left the mapping behind with readers attached: start a fresh ring
+    shmRingHeader_t *ring = producer->ring;
+    memset(ring, 0, sizeof(*ring));
+    ring->capacity = SHM_RING_BYTES;
+    ring->dataOffset = SHM_RING_DATA_OFFSET;
+    ring->version = SHM_RING_VERSION;
+    __atomic_store_n(&ring->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+    REPORT("Shared memory ring %s: %u bytes", name, (unsigned) SHM_RING_BYTES);
+    return 0;
+}
+
+void shmProducerSetPcapHeader(shmProducer_t *producer, const wireSharkGlobalHeader_t *gHeader) {
+    memcpy(producer->ring->pcapHeader, gHeader, sizeof(*gHeader));
+}
+
+// Moves oldestPosition past every slot that the reservation up to \p end overwrites
+static uint64_t shmProducerRetire(shmProducer_t *producer, uint64_t oldest, uint64_t end) {
+    const uint64_t mask = SHM_RING_BYTES - 1;
+
+    while (end - oldest > SHM_RING_BYTES) {
+        const shmRingSlot_t *slot = (const shmRingSlot_t *) &producer->data[oldest & mask];
+        if (slot->length == SHM_RING_PAD) {
+            oldest += SHM_RING_BYTES - (oldest & mask);
+        } else {
+            oldest += SHM_RING_SLOT_SPAN(slot->length);
+        }
+    }
+    return oldest;
+}
+
+_i32 shmProducerWrite(shmProducer_t *producer, const _u8 *record, _u32 length) {
+    const uint64_t mask = SHM_RING_BYTES - 1;
+    shmRingHeader_t *ring = producer->ring;
+
+    uint64_t span = SHM_RING_SLOT_SPAN(length);
+    if (span > SHM_RING_BYTES / 2) {
+        DEBUG("[ERROR] Record of %u bytes does not fit into the ring", length);
+        return -1;
+    }
+
+    uint64_t position = ring->writePosition;
+    uint64_t padding = 0;
+    if (SHM_RING_BYTES - (position & mask) < span) {
+        padding = SHM_RING_BYTES - (position & mask);
+    }
+    uint64_t end = position + padding + span;
+
+    __atomic_store_n(&ring->oldestPosition, shmProducerRetire(producer, ring->oldestPosition, end),
+            __ATOMIC_RELEASE);
+    // Readers check the reservation after reading, it has to be visible before the bytes change
+    __atomic_store_n(&ring->reservePosition, end, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (padding != 0) {
+        shmRingSlot_t *pad = (shmRingSlot_t *) &producer->data[position & mask];
+        pad->length = SHM_RING_PAD;
+        pad->sequence = producer->sequence;
+        position += padding;
+    }
+
+    shmRingSlot_t *slot = (shmRingSlot_t *) &producer->data[position & mask];
+    slot->length = length;
+    slot->sequence = producer->sequence++;
+    memcpy(slot + 1, record, length);
+
+    __atomic_store_n(&ring->writePosition, end, __ATOMIC_SEQ_CST);
+
+    // Only a reader that announced it is about to block costs a system call
+    if (__atomic_load_n(&ring->readerWaiting, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&ring->readerWaiting, 0, __ATOMIC_RELAXED);
+        SetEvent(producer->event);
+    }
+    return 0;
+}
+
+void shmProducerClose(shmProducer_t *producer) {
+    if (producer->ring != NULL) {
+        __atomic_store_n(&producer->ring->producerClosed, 1, __ATOMIC_SEQ_CST);
+        SetEvent(producer->event);
+        UnmapViewOfFile(producer->ring);
+    }
+    if (producer->event != NULL) {
+        CloseHandle(producer->event);
+    }
+    if (producer->mapping != NULL) {
+        CloseHandle(producer->mapping);
+    }
+    memset(producer, 0, sizeof(*producer));
+}
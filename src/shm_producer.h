@@ -0,0 +1,26 @@
+#ifndef __SHM_PRODUCER_H__
+#define __SHM_PRODUCER_H__
+
+#include "simplelink.h"
+#include "pcap.h"
+#include "shm_ring.h"
+
+// Publishing side of the shared-memory ring, see shm_ring.h for the layout
+typedef struct shmProducer {
+    HANDLE mapping;
+    HANDLE event;
+    shmRingHeader_t *ring;
+    _u8 *data;
+    _u32 sequence;
+} shmProducer_t;
+
+_i32 shmProducerOpen(shmProducer_t *producer, const char *name);
+
+void shmProducerSetPcapHeader(shmProducer_t *producer, const wireSharkGlobalHeader_t *gHeader);
+
+// Copies one pcap record into the ring and wakes a waiting reader, never blocks
+_i32 shmProducerWrite(shmProducer_t *producer, const _u8 *record, _u32 length);
+
+void shmProducerClose(shmProducer_t *producer);
+
+#endif /* __SHM_PRODUCER_H__ */
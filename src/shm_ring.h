@@ -0,0 +1,66 @@
+#ifndef __SHM_RING_H__
+#define __SHM_RING_H__
+
+#include <stdint.h>
+
+/*
+ * Layout of the shared-memory ring of pcap records, shared by the sniffer (producer) and the
+ * consumer library. Only fixed-size integer types are used so consumers need nothing but this file,
+ * shm_consumer.h and shm_consumer.c.
+ *
+ * The ring lives in a named file mapping. Positions are monotonic 64 bit byte counters, the offset
+ * in the data area is position & (capacity - 1). Every record is stored in a slot:
+ *
+ *   shmRingSlot_t | pcap record header | radiotap header | 802.11 frame | padding to 8 bytes
+ *
+ * A slot never wraps: when it does not fit before the end of the data area a slot of length
+ * SHM_RING_PAD is written and the record starts over at offset 0.
+ *
+ * The producer never waits for readers. Before writing it publishes reservePosition, the end of the
+ * slot it is about to write, and afterwards writePosition. A reader is lapped, and the bytes it
+ * looks at are garbage, once reservePosition is more than capacity ahead of them; it then resumes
+ * from oldestPosition, the oldest slot the producer has not overwritten.
+ */
+#define SHM_RING_NAME "Local\\cc3100-ring"
+#define SHM_RING_EVENT_SUFFIX "-event"
+
+#ifndef SHM_RING_BYTES
+#define SHM_RING_BYTES (4 * 1024 * 1024) /* power of two */
+#endif
+
+#define SHM_RING_MAGIC 0x52434343 /* "CCCR" */
+#define SHM_RING_VERSION 1
+#define SHM_RING_PAD 0xFFFFFFFF
+#define SHM_RING_ALIGNMENT 8
+#define SHM_RING_DATA_OFFSET 4096
+#define SHM_RING_PCAP_HEADER_BYTES 24
+#define SHM_CACHE_LINE 64
+
+#define SHM_RING_SLOT_SPAN(length) \
+    ((sizeof(shmRingSlot_t) + (length) + SHM_RING_ALIGNMENT - 1) & ~(uint64_t) (SHM_RING_ALIGNMENT - 1))
+
+typedef struct shmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; /* of the data area, in octets */
+    uint32_t dataOffset; /* from the start of the mapping */
+    uint8_t pcapHeader[SHM_RING_PCAP_HEADER_BYTES]; /* pcap global header of the records */
+    uint32_t producerClosed;
+    uint8_t pad0[SHM_CACHE_LINE - 44];
+
+    // written by the producer only
+    uint64_t reservePosition;
+    uint64_t writePosition;
+    uint64_t oldestPosition;
+    uint8_t pad1[SHM_CACHE_LINE - 24];
+
+    // set by a reader that is about to block on the event, cleared by the producer
+    uint32_t readerWaiting;
+} shmRingHeader_t;
+
+typedef struct shmRingSlot {
+    uint32_t length; /* of the pcap record, SHM_RING_PAD skips to the start of the data area */
+    uint32_t sequence; /* of the record, lets readers count what they lost */
+} shmRingSlot_t;
+
+#endif /* __SHM_RING_H__ */
@@ -1,124 +1,168 @@
 #include "main.h"
 
-// https://wiki.wireshark.org/Development/LibpcapFileFormat
-typedef struct wireSharkGlobalHeader {
-    uint32_t magic_number; /* magic number */
-    uint16_t version_major; /* major version number */
-    uint16_t version_minor; /* minor version number */
-    int32_t thiszone; /* GMT to local correction */
-    uint32_t sigfigs; /* accuracy of timestamps */
-    uint32_t snaplen; /* max length of captured packets, in octets */
-    uint32_t network; /* data link type */
-} wireSharkGlobalHeader_t;
-
-typedef struct pcapRecordHeader {
-    uint32_t ts_sec; /* timestamp seconds */
-    uint32_t ts_usec; /* timestamp microseconds */
-    uint32_t incl_len; /* number of octets of packet saved in file */
-    uint32_t orig_len; /* actual length of packet */
-} pcapRecordHeader_t;
-
-// http://www.radiotap.org/
-typedef struct ieee80211RadiotapHeader {
-    uint8_t it_version; /* set to 0 */
-    uint8_t it_pad;
-    uint16_t it_len; /* entire length */
-    uint32_t it_present; /* fields present */
-} ieee80211RadiotapHeader_t;
-
-int sniffByWireshark(_i16 channel) {
-    HANDLE hPipe = CreateNamedPipe(TEXT("\\\\.\\pipe\\cc3100"), PIPE_ACCESS_OUTBOUND,
-    PIPE_TYPE_MESSAGE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES, 65536, 65536,
-    NMPWAIT_USE_DEFAULT_WAIT, NULL);
-
-    if (hPipe == INVALID_HANDLE_VALUE) {
-        DEBUG("[ERROR] Failed to create pipe");
+#define RECV_TIMEOUT_MS 200 /* how long an idle channel keeps Ctrl+C and Ctrl+Break waiting */
+
+static void captureReport(const probeStats_t *probes, const trigger_t *trigger,
+        const shaping_t *shaping) {
+    latencyReport();
+    probeReport(probes);
+    if (shaping != NULL) {
+        shapingReport(shaping);
+    }
+    if (trigger != NULL) {
+        triggerReport(trigger);
+    }
+}
+
+int sniffByWireshark(const options_t *options) {
+    // Everything the capture loop touches is reserved up front, the loop itself never allocates
+    _u8 *buffer = arenaAlloc(ARENA_CAPTURE, PCAP_RECORD_HEADROOM + CAPTURE_MTU);
+    if (buffer == NULL) {
         return -1;
     }
+    _u8 *receiveArea = buffer + PCAP_RECORD_HEADROOM;
 
-    DEBUG("Waiting for connection from WireShark...");
-    DEBUG("pipe: \\\\.\\pipe\\cc3100");
+    if (latencyInit() < 0) {
+        return -1;
+    }
+
+    trigger_t trigger;
+    trigger_t *activeTrigger = NULL;
+    if (options->trigger.conditions != 0) {
+        if (triggerInit(&trigger, &options->trigger) < 0) {
+            return -1;
+        }
+        activeTrigger = &trigger;
+    }
 
-    BOOL fConnected = ConnectNamedPipe(hPipe, NULL);
+    shaping_t shaping;
+    shaping_t *activeShaping = NULL;
+    if (shapingEnabled(&options->shaping)) {
+        if (shapingInit(&shaping, &options->shaping) < 0) {
+            return -1;
+        }
+        activeShaping = &shaping;
+    }
 
-    if (fConnected == 0) {
-        DEBUG("[ERROR] Failed to ConnectNamedPipe");
+    output_t out;
+    captureIndex_t index;
+    shmProducer_t shm;
+    if (options->sharedMemory) {
+        if (outputOpenSharedMemory(&out, options->ringName, &shm) < 0) {
+            return -1;
+        }
+    } else if (options->outputPath != NULL) {
+        if (outputOpenFile(&out, options->outputPath, &index) < 0) {
+            return -1;
+        }
+    } else if (outputOpenPipe(&out, TEXT(WIRESHARK_PIPE_NAME)) < 0) {
         return -1;
     }
-    DEBUG("WireShark connected");
-
-    wireSharkGlobalHeader_t gHeader = {
-            .magic_number = 0xA1B2C3d4,
-            .version_major = 2,
-            .version_minor = 4,
-            .thiszone = 0,
-            .sigfigs = 0,
-            .snaplen = 0x0000FFFF,
-            .network = 127,
-    };
-
-    LPDWORD byteWritten;
-    BOOL result = WriteFile(hPipe, &gHeader, sizeof(gHeader), &byteWritten, NULL);
-
-    if (result == FALSE) {
+
+    arenaSeal();
+    arenaReport();
+
+    wireSharkGlobalHeader_t gHeader;
+    pcapGlobalHeader(&gHeader);
+
+    // From here on every exit closes the output, which flushes the batch and the last index entry
+    if (outputWriteGlobalHeader(&out, &gHeader) < 0) {
         DEBUG("[ERROR] Failed to write global header");
+        outputClose(&out);
         return -1;
     }
 
-    _i16 SockID = sl_Socket(SL_AF_RF, SL_SOCK_RAW, channel);
+    _i16 SockID = sl_Socket(SL_AF_RF, SL_SOCK_RAW, options->channel);
 
     if (SockID < 0) {
         DEBUG("Can not create socket: %d", SockID);
+        outputClose(&out);
+        return -1;
+    }
+
+    SlTimeval_t recvTimeout = { 0, RECV_TIMEOUT_MS * 1000 };
+    if (sl_SetSockOpt(SockID, SL_SOL_SOCKET, SL_SO_RCVTIMEO, &recvTimeout,
+            sizeof(recvTimeout)) < 0) {
+        DEBUG("[ERROR] Failed to set the receive timeout");
+        outputClose(&out);
+        sl_Close(SockID);
         return -1;
     }
 
-    const int BUFFER_SIZE = 1536;
-    _u8 buffer[BUFFER_SIZE];
-    while (TRUE) {
-        _i16 recievedBytes = sl_Recv(SockID, buffer, sizeof(buffer), 0);
+    // Ctrl+Break dumps the statistics, Ctrl+C stops the capture within RECV_TIMEOUT_MS
+    installCtrlHandler();
+
+    pcapClock_t clock = { 0 };
+    // Frames of the traffic generator are accounted before shaping drops any of them
+    probeStats_t probes = { 0 };
+    _i32 retVal = 0;
+
+    while (!isStopRequested()) {
+        if (takeReportRequest()) {
+            captureReport(&probes, activeTrigger, activeShaping);
+        }
+
+        latencyTick_t recvStart = latencyNow();
+        _i16 recievedBytes = sl_Recv(SockID, receiveArea, CAPTURE_MTU, 0);
+        latencyTick_t arrival = latencyNow();
 
+        if (recievedBytes == SL_EAGAIN) {
+            continue;
+        }
         if (recievedBytes < 0) {
             DEBUG("[ERROR] Recv: %d", recievedBytes);
-            return -1;
+            retVal = -1;
+            break;
         }
-
-        SlTransceiverRxOverHead_t * radioHeader = (SlTransceiverRxOverHead_t *) buffer;
-        DEBUG("RSSI: %d, channel: %u, RATE: %u", radioHeader->rssi, radioHeader->channel,
-                radioHeader->rate);
-
-        const int MICROSECONDS_IN_SECOND = 1000000;
-        pcapRecordHeader_t pcapHeader = {
-                .ts_sec = radioHeader->timestamp / MICROSECONDS_IN_SECOND,
-                .ts_usec = radioHeader->timestamp % MICROSECONDS_IN_SECOND,
-                .incl_len = recievedBytes - sizeof(SlTransceiverRxOverHead_t)
-                        + sizeof(ieee80211RadiotapHeader_t),
-                .orig_len = recievedBytes - sizeof(SlTransceiverRxOverHead_t)
-                        + sizeof(ieee80211RadiotapHeader_t),
-        };
-        result = WriteFile(hPipe, &pcapHeader, sizeof(pcapHeader), &byteWritten, NULL);
-        if (result == FALSE) {
-            DEBUG("[ERROR] Failed to write pcapRecordHeader_t");
-            return -1;
+        if (recievedBytes < (_i16) sizeof(SlTransceiverRxOverHead_t)) {
+            DEBUG("[ERROR] Transfer of %d bytes is shorter than its header, skipped",
+                    recievedBytes);
+            continue;
         }
 
-        ieee80211RadiotapHeader_t radiotapHeader = {
-                .it_version = 0,
-                .it_len = sizeof(ieee80211RadiotapHeader_t),
-        };
-        result = WriteFile(hPipe, &radiotapHeader, sizeof(radiotapHeader), &byteWritten, NULL);
-        if (result == FALSE) {
-            DEBUG("[ERROR] Failed to write pcapRecordHeader_t");
-            return -1;
+        SlTransceiverRxOverHead_t radioHeader;
+        memcpy(&radioHeader, receiveArea, sizeof(radioHeader));
+        DEBUG("RSSI: %d, channel: %u, RATE: %u", radioHeader.rssi, radioHeader.channel,
+                radioHeader.rate);
+
+        uint64_t timestampUs = pcapClockExtend(&clock, radioHeader.timestamp);
+        latencyRecord(LATENCY_RECV, recvStart, arrival);
+        latencyRecordDevice(timestampUs, arrival);
+
+        // Starts after the console output of the debug build, which would dwarf the record building
+        latencyTick_t buildStart = latencyNow();
+        _u32 recordLength = 0;
+        _u8 *record = pcapWrapFrame(&receiveArea[sizeof(SlTransceiverRxOverHead_t)],
+                recievedBytes - sizeof(SlTransceiverRxOverHead_t), timestampUs, radioHeader.rssi,
+                radioHeader.channel, &recordLength);
+        latencyTick_t built = latencyNow();
+        latencyRecord(LATENCY_BUILD, buildStart, built);
+        probeObserve(&probes, record, arrival);
+
+        BOOL kept = activeShaping == NULL
+                || shapingAccept(activeShaping, record, recordLength) == SHAPING_KEPT;
+        if (!kept && activeTrigger == NULL) {
+            continue;
         }
 
-        result = WriteFile(hPipe, &(buffer[sizeof(SlTransceiverRxOverHead_t)]),
-                recievedBytes - sizeof(SlTransceiverRxOverHead_t), &byteWritten, NULL);
-
-        if (result == FALSE) {
-            DEBUG("[ERROR] Failed to write buffer");
-            return -1;
+        // Triggers see every frame, shaping only decides which frames are stored and written
+        _i32 written = activeTrigger != NULL ?
+                triggerOffer(activeTrigger, record, recordLength, kept, &out) :
+                outputWriteRecord(&out, record, recordLength);
+        if (written < 0) {
+            DEBUG("[ERROR] Failed to write pcap record");
+            retVal = -1;
+            break;
         }
+        latencyRecord(LATENCY_WRITE, built, latencyNow());
     }
 
-    return sl_Close(SockID);
+    if (outputClose(&out) < 0) {
+        retVal = -1;
+    }
+    captureReport(&probes, activeTrigger, activeShaping);
+    if (sl_Close(SockID) < 0) {
+        retVal = -1;
+    }
+    return retVal;
 }
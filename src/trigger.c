@@ -0,0 +1,199 @@
+#include "main.h"
+
+#define ASSOC_STATUS_OFFSET 2 /* after the capability information */
+#define ASSOC_STATUS_SUCCESS 0
+
+// Records are stored 4 byte aligned so their headers can be read in place on the MCU as well
+#define RECORD_ALIGNMENT 4
+#define RECORD_SPAN(length) (((length) + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1))
+
+static _u32 triggerRecordLength(const trigger_t *trigger, _u32 position) {
+    const pcapRecordHeader_t *header = (const pcapRecordHeader_t *) &trigger->buffer[position];
+    return sizeof(pcapRecordHeader_t) + header->incl_len;
+}
+
+static uint64_t triggerRecordTimestamp(const trigger_t *trigger, _u32 position) {
+    return pcapRecordTimestamp((const pcapRecordHeader_t *) &trigger->buffer[position]);
+}
+
+static void triggerClear(trigger_t *trigger) {
+    trigger->head = 0;
+    trigger->tail = 0;
+    trigger->wrapEnd = 0;
+    trigger->wrapped = FALSE;
+    trigger->records = 0;
+}
+
+static void triggerEvictOldest(trigger_t *trigger) {
+    trigger->head += RECORD_SPAN(triggerRecordLength(trigger, trigger->head));
+    trigger->records--;
+    trigger->recordsDiscarded++;
+
+    if (trigger->records == 0) {
+        triggerClear(trigger);
+    } else if (trigger->wrapped && trigger->head == trigger->wrapEnd) {
+        trigger->head = 0;
+        trigger->wrapped = FALSE;
+    }
+}
+
+// Finds room for \p length contiguous octets, evicting the oldest records when the buffer is full
+static _u32 triggerReserve(trigger_t *trigger, _u32 length) {
+    while (TRUE) {
+        if (!trigger->wrapped) {
+            if (TRIGGER_BUFFER_BYTES - trigger->tail >= length) {
+                return trigger->tail;
+            }
+            if (trigger->records == 0) {
+                triggerClear(trigger);
+                continue;
+            }
+            trigger->wrapEnd = trigger->tail;
+            trigger->tail = 0;
+            trigger->wrapped = TRUE;
+        }
+
+        if (trigger->head - trigger->tail >= length) {
+            return trigger->tail;
+        }
+        triggerEvictOldest(trigger);
+    }
+}
+
+static void triggerStore(trigger_t *trigger, const _u8 *record, _u32 length, uint64_t nowUs) {
+    while (trigger->records > 0
+            && triggerRecordTimestamp(trigger, trigger->head) + trigger->config.preUs < nowUs) {
+        triggerEvictOldest(trigger);
+    }
+
+    _u32 position = triggerReserve(trigger, RECORD_SPAN(length));
+    memcpy(&trigger->buffer[position], record, length);
+    trigger->tail = position + RECORD_SPAN(length);
+    trigger->records++;
+}
+
+static _i32 triggerFlush(trigger_t *trigger, output_t *out) {
+    _u32 position = trigger->head;
+    while (trigger->records > 0) {
+        _u32 length = triggerRecordLength(trigger, position);
+        _i32 retVal = outputWriteRecord(out, &trigger->buffer[position], length);
+        ASSERT_ON_ERROR(retVal);
+        trigger->recordsWritten++;
+        trigger->records--;
+
+        position += RECORD_SPAN(length);
+        if (trigger->wrapped && position == trigger->wrapEnd) {
+            position = 0;
+            trigger->wrapped = FALSE;
+        }
+    }
+    triggerClear(trigger);
+    return outputFlush(out);
+}
+
+static BOOL triggerAddressSeen(const triggerConfig_t *config, const ieee80211Frame_t *parsed) {
+    for (_u32 i = 0; i < config->addressCount; i++) {
+        if (ieee80211Carries(parsed, config->addresses[i])) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static BOOL triggerMatches(trigger_t *trigger, const _u8 *record, uint64_t nowUs) {
+    _u32 frameLength = 0;
+    const _u8 *frame = pcapRecordFrame(record, &frameLength);
+    ieee80211Frame_t parsed;
+    if (frame == NULL || ieee80211Parse(frame, frameLength, &parsed) < 0) {
+        return FALSE;
+    }
+
+    const triggerConfig_t *config = &trigger->config;
+    BOOL management = parsed.type == IEEE80211_TYPE_MANAGEMENT;
+
+    if ((config->conditions & TRIGGER_DEAUTH_FLOOD) && management
+            && (parsed.subtype == IEEE80211_SUBTYPE_DEAUTH
+                    || parsed.subtype == IEEE80211_SUBTYPE_DISASSOC)) {
+        // floodTimes[floodNext] is the oldest of the last TRIGGER_FLOOD_FRAMES such frames
+        uint64_t oldestUs = trigger->floodTimes[trigger->floodNext];
+        trigger->floodTimes[trigger->floodNext] = nowUs;
+        trigger->floodNext = (trigger->floodNext + 1) % TRIGGER_FLOOD_FRAMES;
+
+        if (oldestUs != 0 && nowUs - oldestUs <= TRIGGER_FLOOD_WINDOW_US) {
+            DEBUG("Trigger: deauthentication flood");
+            return TRUE;
+        }
+    }
+
+    if ((config->conditions & TRIGGER_ASSOC_FAILURE) && management
+            && (parsed.subtype == IEEE80211_SUBTYPE_ASSOC_RESPONSE
+                    || parsed.subtype == IEEE80211_SUBTYPE_REASSOC_RESPONSE)
+            && parsed.bodyLength >= ASSOC_STATUS_OFFSET + 2) {
+        _u16 status = parsed.body[ASSOC_STATUS_OFFSET] | (parsed.body[ASSOC_STATUS_OFFSET + 1] << 8);
+        if (status != ASSOC_STATUS_SUCCESS) {
+            DEBUG("Trigger: association failed with status %u", status);
+            return TRUE;
+        }
+    }
+
+    if ((config->conditions & TRIGGER_ADDRESS) && triggerAddressSeen(config, &parsed)) {
+        DEBUG("Trigger: address seen");
+        return TRUE;
+    }
+    return FALSE;
+}
+
+_i32 triggerInit(trigger_t *trigger, const triggerConfig_t *config) {
+    memset(trigger, 0, sizeof(*trigger));
+    trigger->config = *config;
+
+    trigger->buffer = arenaAlloc(ARENA_TRIGGER, TRIGGER_BUFFER_BYTES);
+    if (trigger->buffer == NULL) {
+        return -1;
+    }
+    return 0;
+}
+
+_i32 triggerOffer(trigger_t *trigger, const _u8 *record, _u32 length, BOOL keep, output_t *out) {
+    if (keep && RECORD_SPAN(length) > TRIGGER_BUFFER_BYTES) {
+        DEBUG("[ERROR] Record of %u bytes does not fit into the trigger buffer", length);
+        return -1;
+    }
+
+    uint64_t nowUs = pcapRecordTimestamp((const pcapRecordHeader_t *) record);
+    BOOL matched = triggerMatches(trigger, record, nowUs);
+
+    if (matched) {
+        trigger->fired++;
+        trigger->postUntilUs = nowUs + trigger->config.postUs;
+    }
+
+    if (trigger->firing && nowUs > trigger->postUntilUs) {
+        trigger->firing = FALSE;
+        _i32 retVal = outputFlush(out);
+        ASSERT_ON_ERROR(retVal);
+    }
+
+    if (trigger->firing) {
+        if (!keep) {
+            return 0;
+        }
+        trigger->recordsWritten++;
+        return outputWriteRecord(out, record, length);
+    }
+
+    if (keep) {
+        triggerStore(trigger, record, length, nowUs);
+    }
+    if (matched) {
+        trigger->firing = TRUE;
+        return triggerFlush(trigger, out);
+    }
+    return 0;
+}
+
+void triggerReport(const trigger_t *trigger) {
+    REPORT("Trigger: fired %u time(s), %llu records written, %llu discarded", trigger->fired,
+            (unsigned long long) trigger->recordsWritten,
+            (unsigned long long) trigger->recordsDiscarded);
+}
@@ -0,0 +1,78 @@
+#ifndef __TRIGGER_H__
+#define __TRIGGER_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+#include "ieee80211.h"
+#include "output.h"
+
+/*
+ * Trigger mode keeps the most recent frames in a circular buffer taken from the arena and only
+ * writes them out when a trigger condition matches: the pre-trigger window from the buffer,
+ * then every frame of the post-trigger window as it arrives. The pre-trigger window is bounded both
+ * by triggerConfig_t.preUs and by TRIGGER_BUFFER_BYTES.
+ */
+#ifndef TRIGGER_BUFFER_BYTES
+#define TRIGGER_BUFFER_BYTES (32 * 1024)
+#endif
+
+#define TRIGGER_DEFAULT_PRE_SECONDS 10
+#define TRIGGER_DEFAULT_POST_SECONDS 10
+
+// Deauthentication/disassociation flood: that many frames within TRIGGER_FLOOD_WINDOW_US
+#define TRIGGER_FLOOD_FRAMES 16
+#define TRIGGER_FLOOD_WINDOW_US 1000000
+
+#define TRIGGER_MAX_ADDRESSES 8
+
+typedef enum
+{
+    TRIGGER_DEAUTH_FLOOD = 1 << 0,
+    TRIGGER_ASSOC_FAILURE = 1 << 1, /* (re)association response with a non-zero status code */
+    TRIGGER_ADDRESS = 1 << 2, /* a frame to, from or about one of triggerConfig_t.addresses */
+} e_TriggerCondition;
+
+typedef struct triggerConfig {
+    _u32 conditions; /* e_TriggerCondition bits, 0 disables trigger mode */
+    uint64_t preUs;
+    uint64_t postUs;
+    _u8 addresses[TRIGGER_MAX_ADDRESSES][IEEE80211_ADDRESS_LENGTH];
+    _u32 addressCount;
+} triggerConfig_t;
+
+typedef struct trigger {
+    triggerConfig_t config;
+
+    _u8 *buffer;
+    _u32 head; /* oldest record */
+    _u32 tail; /* where the next record goes */
+    _u32 wrapEnd; /* end of the records stored behind head when wrapped */
+    BOOL wrapped;
+    _u32 records;
+
+    uint64_t postUntilUs; /* frames up to this timestamp are written straight through */
+    BOOL firing;
+
+    uint64_t floodTimes[TRIGGER_FLOOD_FRAMES]; /* of the most recent deauth/disassoc frames */
+    _u32 floodNext;
+
+    _u32 fired;
+    uint64_t recordsWritten;
+    uint64_t recordsDiscarded;
+} trigger_t;
+
+_i32 triggerInit(trigger_t *trigger, const triggerConfig_t *config);
+
+/*!
+ \brief Evaluates the trigger conditions on the record, buffers it and writes whatever the trigger
+ state asks for to \p out.
+
+ Conditions are evaluated on every record received. A record that \p keep is FALSE for, e.g. one
+ dropped by shaping, can fire the trigger but is neither buffered nor written.
+ */
+_i32 triggerOffer(trigger_t *trigger, const _u8 *record, _u32 length, BOOL keep, output_t *out);
+
+void triggerReport(const trigger_t *trigger);
+
+#endif /* __TRIGGER_H__ */
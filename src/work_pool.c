@@ -0,0 +1,144 @@
+#include "main.h"
+
+#define DEQUE_MASK (WORK_POOL_DEQUE_SLOTS - 1)
+
+static BOOL workDequePush(workDeque_t *deque, const workItem_t *item) {
+    BOOL pushed = FALSE;
+    EnterCriticalSection(&deque->lock);
+    if (deque->bottom - deque->top < WORK_POOL_DEQUE_SLOTS) {
+        deque->items[deque->bottom++ & DEQUE_MASK] = *item;
+        pushed = TRUE;
+    }
+    LeaveCriticalSection(&deque->lock);
+    return pushed;
+}
+
+static BOOL workDequeTake(workDeque_t *deque, BOOL steal, workItem_t *item) {
+    BOOL taken = FALSE;
+    EnterCriticalSection(&deque->lock);
+    if (deque->top != deque->bottom) {
+        *item = steal ? deque->items[deque->top++ & DEQUE_MASK] :
+                deque->items[--deque->bottom & DEQUE_MASK];
+        taken = TRUE;
+    }
+    LeaveCriticalSection(&deque->lock);
+    return taken;
+}
+
+static BOOL workPoolTake(workPool_t *pool, workDeque_t *own, workItem_t *item) {
+    BOOL taken = workDequeTake(own, FALSE, item);
+    for (_u32 i = 1; !taken && i < pool->threads; i++) {
+        taken = workDequeTake(&pool->deques[(own->worker + i) % pool->threads], TRUE, item);
+        own->stolen += taken;
+    }
+    if (taken) {
+        InterlockedDecrement(&pool->pending);
+    }
+    return taken;
+}
+
+static DWORD WINAPI workPoolWorker(LPVOID parameter) {
+    workDeque_t *own = parameter;
+    workPool_t *pool = own->pool;
+
+    for (;;) {
+        WaitForSingleObject(pool->available, INFINITE);
+
+        // Holding a unit guarantees an item somewhere, unless everything was taken after finishing
+        workItem_t item;
+        while (!workPoolTake(pool, own, &item)) {
+            if (pool->finished && pool->pending == 0) {
+                return 0;
+            }
+            YieldProcessor();
+        }
+
+        pool->run(pool->context, own->worker, &item);
+        own->executed++;
+    }
+}
+
+_u32 workPoolDefaultThreads() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    _u32 threads = info.dwNumberOfProcessors;
+    if (threads < 1) {
+        threads = 1;
+    }
+    return threads > WORK_POOL_MAX_THREADS ? WORK_POOL_MAX_THREADS : threads;
+}
+
+_i32 workPoolStart(workPool_t *pool, _u32 threads, workRun_t run, void *context) {
+    memset(pool, 0, sizeof(*pool));
+    if (threads < 1 || threads > WORK_POOL_MAX_THREADS) {
+        DEBUG("[ERROR] A pool has 1-%u threads", WORK_POOL_MAX_THREADS);
+        return -1;
+    }
+    pool->run = run;
+    pool->context = context;
+
+    pool->available = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+    if (pool->available == NULL) {
+        DEBUG("[ERROR] Failed to create the semaphore: %lu", GetLastError());
+        return -1;
+    }
+
+    for (_u32 i = 0; i < threads; i++) {
+        workDeque_t *deque = &pool->deques[i];
+        deque->pool = pool;
+        deque->worker = i;
+        InitializeCriticalSection(&deque->lock);
+    }
+    for (; pool->threads < threads; pool->threads++) {
+        pool->handles[pool->threads] = CreateThread(NULL, 0, workPoolWorker,
+                &pool->deques[pool->threads], 0, NULL);
+        if (pool->handles[pool->threads] == NULL) {
+            DEBUG("[ERROR] Failed to start worker %u: %lu", pool->threads, GetLastError());
+            break;
+        }
+    }
+
+    // The workers that did start run the whole load
+    return pool->threads > 0 ? 0 : -1;
+}
+
+void workPoolSubmit(workPool_t *pool, const workItem_t *item) {
+    for (;;) {
+        for (_u32 i = 0; i < pool->threads; i++) {
+            workDeque_t *deque = &pool->deques[pool->next];
+            pool->next = (pool->next + 1) % pool->threads;
+            if (workDequePush(deque, item)) {
+                InterlockedIncrement(&pool->pending);
+                ReleaseSemaphore(pool->available, 1, NULL);
+                return;
+            }
+        }
+        // The workers are behind by WORK_POOL_DEQUE_SLOTS items each
+        Sleep(1);
+    }
+}
+
+void workPoolFinish(workPool_t *pool) {
+    InterlockedExchange(&pool->finished, TRUE);
+    if (pool->threads > 0) {
+        ReleaseSemaphore(pool->available, pool->threads, NULL);
+        WaitForMultipleObjects(pool->threads, pool->handles, TRUE, INFINITE);
+    }
+
+    for (_u32 i = 0; i < pool->threads; i++) {
+        CloseHandle(pool->handles[i]);
+    }
+    for (_u32 i = 0; i < WORK_POOL_MAX_THREADS && pool->deques[i].pool != NULL; i++) {
+        DeleteCriticalSection(&pool->deques[i].lock);
+    }
+    CloseHandle(pool->available);
+}
+
+void workPoolReport(const workPool_t *pool) {
+    REPORT("Work pool of %u threads:", pool->threads);
+    for (_u32 i = 0; i < pool->threads; i++) {
+        REPORT("  worker %-3u %8llu chunks, %llu stolen", i,
+                (unsigned long long) pool->deques[i].executed,
+                (unsigned long long) pool->deques[i].stolen);
+    }
+}
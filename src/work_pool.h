@@ -0,0 +1,65 @@
+#ifndef __WORK_POOL_H__
+#define __WORK_POOL_H__
+
+#include <stdint.h>
+
+#include "simplelink.h"
+
+/*
+ * Work-stealing thread pool for the offline tools.
+ *
+ * Every worker owns a deque. Submitted items are dealt round-robin to the deques; a worker takes the
+ * newest item of its own deque and, once that is empty, steals the oldest item of another one, so a
+ * worker stuck with expensive items does not hold up the rest. Items are coarse (a chunk of a capture
+ * file), so a lock per deque costs nothing measurable.
+ */
+#define WORK_POOL_MAX_THREADS 64 /* MAXIMUM_WAIT_OBJECTS */
+#define WORK_POOL_DEQUE_SLOTS 64 /* power of two */
+
+typedef struct workItem {
+    uint64_t start;
+    uint64_t end;
+} workItem_t;
+
+// Runs one item on thread \p worker, 0 to threads - 1
+typedef void (*workRun_t)(void *context, _u32 worker, const workItem_t *item);
+
+struct workPool;
+
+typedef struct workDeque {
+    struct workPool *pool;
+    _u32 worker;
+    CRITICAL_SECTION lock;
+    _u32 top; /* oldest item, stolen first */
+    _u32 bottom; /* one past the newest item, taken by the owner */
+    workItem_t items[WORK_POOL_DEQUE_SLOTS];
+    uint64_t executed;
+    uint64_t stolen; /* of the executed items, taken from another deque */
+} __attribute__((aligned(64))) workDeque_t;
+
+typedef struct workPool {
+    workRun_t run;
+    void *context;
+    _u32 threads;
+    _u32 next; /* deque of the next submission */
+    HANDLE available; /* one unit per submitted item, and one per thread once finished */
+    volatile LONG pending; /* submitted items nobody has taken yet */
+    volatile LONG finished;
+    HANDLE handles[WORK_POOL_MAX_THREADS];
+    workDeque_t deques[WORK_POOL_MAX_THREADS];
+} workPool_t;
+
+// Number of logical processors, the default size of a pool
+_u32 workPoolDefaultThreads();
+
+_i32 workPoolStart(workPool_t *pool, _u32 threads, workRun_t run, void *context);
+
+// Queues an item, waits while every deque is full
+void workPoolSubmit(workPool_t *pool, const workItem_t *item);
+
+// Waits until every submitted item has run and the workers have exited
+void workPoolFinish(workPool_t *pool);
+
+void workPoolReport(const workPool_t *pool);
+
+#endif /* __WORK_POOL_H__ */